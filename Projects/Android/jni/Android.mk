@@ -17,6 +17,20 @@ LOCAL_SRC_FILES          += ../../../Src/CoreModel.cpp
 LOCAL_SRC_FILES          += ../../../Src/CoreMatrix4f.cpp
 LOCAL_SRC_FILES          += ../../../Src/CoreCommon.cpp
 LOCAL_SRC_FILES          += ../../../Src/CoreTexture.cpp
+LOCAL_SRC_FILES          += ../../../Src/SceneGraph.cpp
+LOCAL_SRC_FILES          += ../../../Src/TransformKernel.cpp
+LOCAL_SRC_FILES          += ../../../Src/DrawList.cpp
+LOCAL_SRC_FILES          += ../../../Src/TriangleBVH.cpp
+LOCAL_SRC_FILES          += ../../../Src/GazeBroadphase.cpp
+LOCAL_SRC_FILES          += ../../../Src/CollisionThread.cpp
+LOCAL_SRC_FILES          += ../../../Src/CoreFrameEvent.cpp
+LOCAL_SRC_FILES          += ../../../Src/MathPool.cpp
+LOCAL_SRC_FILES          += ../../../Src/CompactVertices.cpp
+# Keep the SIMD and scalar transform kernels rounding alike (no fused multiply-add)
+LOCAL_CFLAGS           += -ffp-contract=off
+ifeq ($(TARGET_ARCH_ABI),armeabi-v7a)
+LOCAL_ARM_NEON         := true
+endif
 LOCAL_STATIC_LIBRARIES := vrsound vrmodel vrlocale vrgui vrappframework systemutils libovrkernel spidermonkey_static bullet_static
 LOCAL_SHARED_LIBRARIES := vrapi libandroid mozglue-prebuilt assimp-prebuilt
 LOCAL_LDLIBS           += -landroid
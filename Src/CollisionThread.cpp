@@ -0,0 +1,94 @@
+#include "CollisionThread.h"
+
+
+void CollisionPass(btCollisionWorld* world, btDiscreteDynamicsWorld* dynamicsWorld, btScalar dt, OVR::Array<uint64_t>& pairs) {
+  if (dynamicsWorld != NULL) {
+    btScalar tickTime = btScalar(1.0) / btScalar(60.0);
+    dynamicsWorld->stepSimulation(dt, 3, tickTime);
+  } else {
+    // One pass over the current transforms, no substeps
+    world->performDiscreteCollisionDetection();
+  }
+
+  pairs.Clear();
+  btDispatcher* dispatcher = world->getDispatcher();
+  int numManifolds = dispatcher->getNumManifolds();
+  for (int i = 0; i < numManifolds; ++i) {
+    btPersistentManifold* contactManifold = dispatcher->getManifoldByIndexInternal(i);
+    uint32_t a = (uint32_t)contactManifold->getBody0()->getUserIndex();
+    uint32_t b = (uint32_t)contactManifold->getBody1()->getUserIndex();
+    uint32_t lo = OVR::Alg::Min(a, b);
+    uint32_t hi = OVR::Alg::Max(a, b);
+    pairs.PushBack(((uint64_t)lo << 32) | hi);
+  }
+}
+
+CollisionThread::CollisionThread(void) :
+  world(NULL),
+  dynamicsWorld(NULL),
+  dt(0),
+  busy(false),
+  quit(false) {
+  pthread_mutex_init(&mutex, NULL);
+  pthread_cond_init(&cond, NULL);
+  if (pthread_create(&thread, NULL, ThreadMain, this) != 0) {
+    __android_log_print(ANDROID_LOG_ERROR, LOG_COMPONENT, "Could not start collision thread\n");
+  }
+}
+
+CollisionThread::~CollisionThread(void) {
+  pthread_mutex_lock(&mutex);
+  while (busy) {
+    pthread_cond_wait(&cond, &mutex);
+  }
+  quit = true;
+  pthread_cond_broadcast(&cond);
+  pthread_mutex_unlock(&mutex);
+  pthread_join(thread, NULL);
+  pthread_cond_destroy(&cond);
+  pthread_mutex_destroy(&mutex);
+}
+
+void CollisionThread::Kick(btCollisionWorld* w, btDiscreteDynamicsWorld* dw, btScalar step) {
+  pthread_mutex_lock(&mutex);
+  while (busy) {
+    pthread_cond_wait(&cond, &mutex);
+  }
+  world = w;
+  dynamicsWorld = dw;
+  dt = step;
+  busy = true;
+  pthread_cond_broadcast(&cond);
+  pthread_mutex_unlock(&mutex);
+}
+
+void CollisionThread::Wait() {
+  pthread_mutex_lock(&mutex);
+  while (busy) {
+    pthread_cond_wait(&cond, &mutex);
+  }
+  pthread_mutex_unlock(&mutex);
+}
+
+void* CollisionThread::ThreadMain(void* param) {
+  CollisionThread* self = (CollisionThread*)param;
+  pthread_mutex_lock(&self->mutex);
+  while (true) {
+    while (!self->busy && !self->quit) {
+      pthread_cond_wait(&self->cond, &self->mutex);
+    }
+    if (self->quit) {
+      break;
+    }
+
+    // The main thread keeps off the world until we're done, so run unlocked
+    pthread_mutex_unlock(&self->mutex);
+    CollisionPass(self->world, self->dynamicsWorld, self->dt, self->pairs);
+    pthread_mutex_lock(&self->mutex);
+
+    self->busy = false;
+    pthread_cond_broadcast(&self->cond);
+  }
+  pthread_mutex_unlock(&self->mutex);
+  return NULL;
+}
@@ -0,0 +1,37 @@
+#ifndef COLLISION_THREAD_H
+#define COLLISION_THREAD_H
+
+#include "BaseInclude.h"
+#include <pthread.h>
+
+// Runs one collision pass: a dynamics step of dt when there's a dynamics
+// world, otherwise a single discrete detection. Then packs the user indices
+// of every manifold's objects into pairs (smaller << 32 | larger).
+void CollisionPass(btCollisionWorld* world, btDiscreteDynamicsWorld* dynamicsWorld, btScalar dt, OVR::Array<uint64_t>& pairs);
+
+// A worker that runs collision passes off the main thread, one per frame.
+// Kick hands it a world to process, and Wait is the fence: the world mustn't
+// be touched, and pairs mustn't be read, between the two.
+class CollisionThread {
+public:
+  OVR::Array<uint64_t> pairs; // Results of the last finished pass
+
+  CollisionThread();
+  ~CollisionThread();
+  void Kick(btCollisionWorld* world, btDiscreteDynamicsWorld* dynamicsWorld, btScalar dt);
+  void Wait();
+
+private:
+  pthread_t thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+  btCollisionWorld* world;
+  btDiscreteDynamicsWorld* dynamicsWorld;
+  btScalar dt;
+  bool busy;
+  bool quit;
+
+  static void* ThreadMain(void* param);
+};
+
+#endif
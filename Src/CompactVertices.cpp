@@ -0,0 +1,156 @@
+#include "CompactVertices.h"
+
+
+static int CompactAttributeSize(int attribute) {
+  switch (attribute) {
+  case VERTEX_POSITION:
+    return 4 * sizeof(int16_t);
+  case VERTEX_UV0:
+  case VERTEX_UV1:
+    return 2 * sizeof(uint16_t);
+  default:
+    return 4 * sizeof(int8_t);
+  }
+}
+
+static int16_t ToSnorm16(float v) {
+  return (int16_t)lrintf(OVR::Alg::Clamp(v, -1.0f, 1.0f) * 32767.0f);
+}
+
+static int8_t ToSnorm8(float v) {
+  return (int8_t)lrintf(OVR::Alg::Clamp(v, -1.0f, 1.0f) * 127.0f);
+}
+
+static uint8_t ToUnorm8(float v) {
+  return (uint8_t)lrintf(OVR::Alg::Clamp(v, 0.0f, 1.0f) * 255.0f);
+}
+
+static uint8_t ToUint8(float v) {
+  return (uint8_t)lrintf(OVR::Alg::Clamp(v, 0.0f, 255.0f));
+}
+
+uint16_t FloatToHalf(float f) {
+  uint32_t bits;
+  memcpy(&bits, &f, sizeof(bits));
+  uint32_t sign = (bits >> 16) & 0x8000;
+  uint32_t floatExponent = (bits >> 23) & 0xFF;
+  uint32_t mantissa = bits & 0x7FFFFF;
+  int exponent = (int)floatExponent - 127 + 15;
+
+  if (floatExponent == 0xFF) {
+    return sign | 0x7C00 | (mantissa != 0 ? 0x200 : 0); // Infinity or NaN
+  }
+  if (exponent >= 31) {
+    return sign | 0x7C00;
+  }
+  if (exponent <= 0) {
+    // Subnormal, or too small for one
+    if (exponent < -10) {
+      return sign;
+    }
+    mantissa |= 0x800000;
+    int shift = 14 - exponent;
+    uint32_t half = mantissa >> shift;
+    if ((mantissa >> (shift - 1)) & 1) {
+      ++half;
+    }
+    return sign | half;
+  }
+  // Rounding may carry into the exponent, which is still the right answer
+  uint32_t half = sign | (exponent << 10) | (mantissa >> 13);
+  if (mantissa & 0x1000) {
+    ++half;
+  }
+  return half;
+}
+
+void PackCompactVertices(const CompactSource* sources, int sourceCount, int vertexCount,
+                         const OVR::Vector3f& center, float scale,
+                         CompactLayout* layout, OVR::Array<uint8_t>& out) {
+  layout->attributeCount = 0;
+  layout->stride = 0;
+  for (int s = 0; s < sourceCount; ++s) {
+    int n = layout->attributeCount++;
+    layout->attributes[n] = sources[s].attribute;
+    layout->offsets[n] = layout->stride;
+    layout->stride += CompactAttributeSize(sources[s].attribute);
+  }
+
+  float invScale = scale > 0.0f ? 1.0f / scale : 1.0f;
+  out.Resize(vertexCount * layout->stride);
+  for (int s = 0; s < sourceCount; ++s) {
+    const CompactSource& source = sources[s];
+    const float* src = source.data;
+    uint8_t* dst = out.GetDataPtr() + layout->offsets[s];
+    for (int i = 0; i < vertexCount; ++i, src += source.stride, dst += layout->stride) {
+      switch (source.attribute) {
+      case VERTEX_POSITION: {
+        int16_t* p = (int16_t*)dst;
+        p[0] = ToSnorm16((src[0] - center.x) * invScale);
+        p[1] = ToSnorm16((src[1] - center.y) * invScale);
+        p[2] = ToSnorm16((src[2] - center.z) * invScale);
+        p[3] = 0;
+        break;
+      }
+      case VERTEX_NORMAL:
+      case VERTEX_TANGENT:
+      case VERTEX_BINORMAL: {
+        int8_t* n = (int8_t*)dst;
+        n[0] = ToSnorm8(src[0]);
+        n[1] = ToSnorm8(src[1]);
+        n[2] = ToSnorm8(src[2]);
+        n[3] = 0;
+        break;
+      }
+      case VERTEX_UV0:
+      case VERTEX_UV1: {
+        uint16_t* uv = (uint16_t*)dst;
+        uv[0] = FloatToHalf(src[0]);
+        uv[1] = FloatToHalf(src[1]);
+        break;
+      }
+      case VERTEX_JOINT_INDICES: {
+        for (int c = 0; c < 4; ++c) {
+          dst[c] = ToUint8(src[c]);
+        }
+        break;
+      }
+      default: {
+        // Colors and joint weights
+        for (int c = 0; c < 4; ++c) {
+          dst[c] = ToUnorm8(src[c]);
+        }
+        break;
+      }
+      }
+    }
+  }
+}
+
+void BindCompactAttributes(const CompactLayout& layout) {
+  for (int i = 0; i < layout.attributeCount; ++i) {
+    int attribute = layout.attributes[i];
+    const GLvoid* offset = (const GLvoid*)(size_t)layout.offsets[i];
+    glEnableVertexAttribArray(attribute);
+    switch (attribute) {
+    case VERTEX_POSITION:
+      glVertexAttribPointer(attribute, 3, GL_SHORT, GL_TRUE, layout.stride, offset);
+      break;
+    case VERTEX_NORMAL:
+    case VERTEX_TANGENT:
+    case VERTEX_BINORMAL:
+      glVertexAttribPointer(attribute, 3, GL_BYTE, GL_TRUE, layout.stride, offset);
+      break;
+    case VERTEX_UV0:
+    case VERTEX_UV1:
+      glVertexAttribPointer(attribute, 2, GL_HALF_FLOAT, GL_FALSE, layout.stride, offset);
+      break;
+    case VERTEX_JOINT_INDICES:
+      glVertexAttribPointer(attribute, 4, GL_UNSIGNED_BYTE, GL_FALSE, layout.stride, offset);
+      break;
+    default:
+      glVertexAttribPointer(attribute, 4, GL_UNSIGNED_BYTE, GL_TRUE, layout.stride, offset);
+      break;
+    }
+  }
+}
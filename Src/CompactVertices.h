@@ -0,0 +1,39 @@
+#ifndef COMPACT_VERTICES_H
+#define COMPACT_VERTICES_H
+
+#include "BaseInclude.h"
+#include "ParseVertexAttribs.h"
+
+// A quantized, interleaved vertex format that shaders read unchanged, since GL
+// does all the unpacking:
+//   position            3 x snorm16 (+ pad), relative to a center and scale
+//   normal/tangent/...  3 x snorm8 (+ pad)
+//   color, weights      4 x unorm8
+//   joint indices       4 x uint8, unnormalized
+//   uv0, uv1            2 x half float
+// Positions come out in [-1, 1], so whoever draws them has to fold the
+// dequantization (translate by center, scale by scale) into the model matrix.
+// The scale is uniform so normals aren't skewed by it.
+
+// One float attribute to pack, stride floats apart
+struct CompactSource {
+  int attribute; // VERTEX_* constant
+  const float* data;
+  int stride;
+};
+
+struct CompactLayout {
+  int attributeCount;
+  int attributes[MAX_LAYOUT_ATTRIBUTES]; // VERTEX_* constants
+  int offsets[MAX_LAYOUT_ATTRIBUTES]; // In bytes from the start of the vertex
+  int stride; // Bytes per vertex
+};
+
+void PackCompactVertices(const CompactSource* sources, int sourceCount, int vertexCount,
+                         const OVR::Vector3f& center, float scale,
+                         CompactLayout* layout, OVR::Array<uint8_t>& out);
+// Points the bound VAO's attributes at packed vertices in the bound array buffer
+void BindCompactAttributes(const CompactLayout& layout);
+uint16_t FloatToHalf(float f);
+
+#endif
@@ -59,4 +59,23 @@ OVR::String FullFilePath(OVR::String & fileStr) {
   base.StripTrailing("/");
   // TODO: Strip leading "/" in fileStr
   return base + "/" + fileStr;
+}
+
+// Natives see the prototype too, which has no payload, and anything else
+// script hands them through call or apply
+bool ReportWrongThis(JSContext* cx, const char* className) {
+  JS_ReportError(cx, "Expected this to be a %s", className);
+  return false;
+}
+
+void BumpChangeStamp(JSObject* obj) {
+  JS_SetReservedSlot(obj, CHANGE_STAMP_SLOT, JS::Int32Value(GetChangeStamp(obj) + 1));
+}
+
+int32_t GetChangeStamp(JSObject* obj) {
+  if (JSCLASS_RESERVED_SLOTS(JS_GetClass(obj)) <= CHANGE_STAMP_SLOT) {
+    return 0;
+  }
+  JS::Value stamp = JS_GetReservedSlot(obj, CHANGE_STAMP_SLOT);
+  return stamp.isInt32() ? stamp.toInt32() : 0;
 }
\ No newline at end of file
@@ -13,6 +13,10 @@ const static int VERTEX_UV1 = 6;
 const static int VERTEX_JOINT_INDICES = 7;
 const static int VERTEX_JOINT_WEIGHTS = 8;
 
+// Reserved slot on mutable math objects holding a counter that is bumped on
+// every in-place write, so owners can tell when a shared value has changed
+const static int CHANGE_STAMP_SLOT = 0;
+
 extern OVR::String CURRENT_BASE_DIR;
 
 #define VRJS_GETSET_POST(ClassName, name, POST) \
@@ -32,6 +36,10 @@ extern OVR::String CURRENT_BASE_DIR;
     } \
     JS::RootedObject self(cx, &args.thisv().toObject()); \
     ClassName* item = Get##ClassName(self); \
+    if (item == NULL) { \
+      /* Script sees the class without its Core prefix */ \
+      return ReportWrongThis(cx, #ClassName + 4); \
+    } \
     JS::RootedValue newVal(cx, args[0]); \
     auto* oldVal = item->name##Val; \
     item->name##Val = new JS::Heap<JS::Value>(newVal); \
@@ -60,5 +68,8 @@ bool GetOVRString(JSContext* cx, JS::HandleString s, OVR::String* out);
 bool ValueDefined(JS::Heap<JS::Value>* val);
 void TraceHeap(JSTracer* tracer, JS::Heap<JS::Value>* val, const char* parentName, const char* name);
 OVR::String FullFilePath(OVR::String & fileStr);
+bool ReportWrongThis(JSContext* cx, const char* className);
+void BumpChangeStamp(JSObject* obj);
+int32_t GetChangeStamp(JSObject* obj);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,77 @@
+#include "CoreFrameEvent.h"
+#include "CoreVector3f.h"
+
+enum {
+  FRAME_EVENT_VIEW_POS_SLOT,
+  FRAME_EVENT_VIEW_FWD_SLOT,
+  FRAME_EVENT_NOW_SLOT,
+  FRAME_EVENT_SLOT_COUNT
+};
+
+static JSClass coreFrameEventClass = {
+  "FrameEvent",           /* name */
+  JSCLASS_HAS_RESERVED_SLOTS(FRAME_EVENT_SLOT_COUNT), /* flags */
+};
+
+static bool GetFrameEventSlot(JSContext* cx, unsigned argc, JS::Value* vp, uint32_t slot) {
+  JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
+  JS::RootedObject self(cx, &args.thisv().toObject());
+  if (JS_GetClass(self) != &coreFrameEventClass) {
+    args.rval().setUndefined();
+    return true;
+  }
+  args.rval().set(JS_GetReservedSlot(self, slot));
+  return true;
+}
+
+static bool CoreFrameEvent_get_viewPos(JSContext* cx, unsigned argc, JS::Value *vp) {
+  return GetFrameEventSlot(cx, argc, vp, FRAME_EVENT_VIEW_POS_SLOT);
+}
+
+static bool CoreFrameEvent_get_viewFwd(JSContext* cx, unsigned argc, JS::Value *vp) {
+  return GetFrameEventSlot(cx, argc, vp, FRAME_EVENT_VIEW_FWD_SLOT);
+}
+
+static bool CoreFrameEvent_get_now(JSContext* cx, unsigned argc, JS::Value *vp) {
+  return GetFrameEventSlot(cx, argc, vp, FRAME_EVENT_NOW_SLOT);
+}
+
+static JSPropertySpec CoreFrameEvent_props[] = {
+  JS_PSG("viewPos", CoreFrameEvent_get_viewPos, JSPROP_PERMANENT | JSPROP_ENUMERATE),
+  JS_PSG("viewFwd", CoreFrameEvent_get_viewFwd, JSPROP_PERMANENT | JSPROP_ENUMERATE),
+  JS_PSG("now", CoreFrameEvent_get_now, JSPROP_PERMANENT | JSPROP_ENUMERATE),
+  JS_PS_END
+};
+
+JSObject* NewCoreFrameEvent(JSContext* cx) {
+  JS::RootedObject self(cx, JS_NewObject(cx, &coreFrameEventClass));
+  if (!self) {
+    return NULL;
+  }
+  if (!JS_DefineProperties(cx, self, CoreFrameEvent_props)) {
+    __android_log_print(ANDROID_LOG_ERROR, LOG_COMPONENT, "Could not define properties on frame event\n");
+    return NULL;
+  }
+
+  JS::RootedObject viewPos(cx, NewCoreVector3f(cx, OVR::Vector3f()));
+  JS::RootedObject viewFwd(cx, NewCoreVector3f(cx, OVR::Vector3f()));
+  if (!viewPos || !viewFwd) {
+    return NULL;
+  }
+  JS_SetReservedSlot(self, FRAME_EVENT_VIEW_POS_SLOT, JS::ObjectValue(*viewPos));
+  JS_SetReservedSlot(self, FRAME_EVENT_VIEW_FWD_SLOT, JS::ObjectValue(*viewFwd));
+  JS_SetReservedSlot(self, FRAME_EVENT_NOW_SLOT, JS::DoubleValue(0));
+  return self;
+}
+
+static void SetSlotVector(JSContext* cx, JS::HandleObject ev, uint32_t slot, const OVR::Vector3f& value) {
+  JS::RootedObject vec(cx, &JS_GetReservedSlot(ev, slot).toObject());
+  *GetVector3f(vec) = value;
+  BumpChangeStamp(vec);
+}
+
+void UpdateCoreFrameEvent(JSContext* cx, JS::HandleObject ev, const OVR::Vector3f& viewPos, const OVR::Vector3f& viewFwd, double now) {
+  SetSlotVector(cx, ev, FRAME_EVENT_VIEW_POS_SLOT, viewPos);
+  SetSlotVector(cx, ev, FRAME_EVENT_VIEW_FWD_SLOT, viewFwd);
+  JS_SetReservedSlot(ev, FRAME_EVENT_NOW_SLOT, JS::DoubleValue(now));
+}
@@ -0,0 +1,12 @@
+#ifndef CORE_FRAME_EVENT_H
+#define CORE_FRAME_EVENT_H
+
+#include "BaseInclude.h"
+
+// The ev object handed to every per-frame callback. Its values live in fixed
+// reserved slots, and its vectors are updated in place, so one object can be
+// reused every frame without allocating.
+JSObject* NewCoreFrameEvent(JSContext* cx);
+void UpdateCoreFrameEvent(JSContext* cx, JS::HandleObject ev, const OVR::Vector3f& viewPos, const OVR::Vector3f& viewFwd, double now);
+
+#endif
@@ -1,17 +1,455 @@
 #include "CoreGeometry.h"
+#include "CoreModel.h"
 #include "CoreVector3f.h"
+#include "jsfriendapi.h"
+#include "bullet/BulletCollision/CollisionShapes/btShapeHull.h"
+#include <algorithm>
 
+// Hulls with more points than this get simplified with btShapeHull
+static const int COLLISION_HULL_MAX_VERTICES = 64;
 
-CoreGeometry::CoreGeometry(OVR::VertexAttribs* vert, OVR::Array<OVR::TriangleIndex> idc) {
-  geometry = new OVR::GlGeometry(*vert, idc);
+
+static void NarrowIndices(const OVR::Array<uint32_t>& indices, OVR::Array<uint16_t>& out) {
+  out.Resize(indices.GetSizeI());
+  for (int i = 0; i < indices.GetSizeI(); ++i) {
+    out[i] = (uint16_t)indices[i];
+  }
+}
+
+CoreGeometry::CoreGeometry(OVR::VertexAttribs* vert, const OVR::Array<uint32_t>& idc, bool isCompact) {
   vertices = vert;
   indices = idc;
+  dynamic = false;
+  compact = isCompact;
+  dequantize = OVR::Matrix4f::Identity();
+  layout.attributeCount = 0;
+  layout.stride = 0;
+  ComputeBounds();
+  int vertexCount = vert->position.GetSizeI();
+
+  if (!compact && vertexCount <= SHORT_INDEX_VERTEX_LIMIT) {
+    // Small enough for the framework's 16-bit path
+    OVR::Array<OVR::TriangleIndex> shortIndices;
+    shortIndices.Resize(idc.GetSizeI());
+    for (int i = 0; i < idc.GetSizeI(); ++i) {
+      shortIndices[i] = (OVR::TriangleIndex)idc[i];
+    }
+    geometry = new OVR::GlGeometry(*vert, shortIndices);
+    indexType = GL_UNSIGNED_SHORT;
+  } else {
+    // Either compact, or too many vertices for 16-bit indices. Either way we
+    // interleave the attributes ourselves. Joint indices go in as floats, which
+    // is what the framework's unnormalized GL_INT attribute hands shaders too.
+    OVR::Array<float> jointIndices;
+    jointIndices.Resize(vert->jointIndices.GetSizeI() * 4);
+    for (int i = 0; i < vert->jointIndices.GetSizeI(); ++i) {
+      jointIndices[i * 4 + 0] = (float)vert->jointIndices[i].x;
+      jointIndices[i * 4 + 1] = (float)vert->jointIndices[i].y;
+      jointIndices[i * 4 + 2] = (float)vert->jointIndices[i].z;
+      jointIndices[i * 4 + 3] = (float)vert->jointIndices[i].w;
+    }
+
+    const int attributes[] = { VERTEX_POSITION, VERTEX_NORMAL, VERTEX_TANGENT, VERTEX_BINORMAL,
+                               VERTEX_COLOR, VERTEX_UV0, VERTEX_UV1, VERTEX_JOINT_INDICES,
+                               VERTEX_JOINT_WEIGHTS };
+    const float* streams[] = {
+      (const float*)vert->position.GetDataPtr(), (const float*)vert->normal.GetDataPtr(),
+      (const float*)vert->tangent.GetDataPtr(), (const float*)vert->binormal.GetDataPtr(),
+      (const float*)vert->color.GetDataPtr(), (const float*)vert->uv0.GetDataPtr(),
+      (const float*)vert->uv1.GetDataPtr(), jointIndices.GetDataPtr(),
+      (const float*)vert->jointWeights.GetDataPtr() };
+    const int counts[] = {
+      vert->position.GetSizeI(), vert->normal.GetSizeI(), vert->tangent.GetSizeI(), vert->binormal.GetSizeI(),
+      vert->color.GetSizeI(), vert->uv0.GetSizeI(), vert->uv1.GetSizeI(), vert->jointIndices.GetSizeI(),
+      vert->jointWeights.GetSizeI() };
+    const int components[] = { 3, 3, 3, 3, 4, 2, 2, 4, 4 };
+
+    CompactSource sources[MAX_LAYOUT_ATTRIBUTES];
+    for (int a = 0; a < 9; ++a) {
+      if (counts[a] != vertexCount) {
+        continue;
+      }
+      int n = layout.attributeCount++;
+      layout.attributes[n] = attributes[a];
+      layout.components[n] = components[a];
+      layout.offsets[n] = layout.stride;
+      layout.stride += components[a];
+      sources[n].attribute = attributes[a];
+      sources[n].data = streams[a];
+      sources[n].stride = components[a];
+    }
+
+    const void* indexData = idc.GetDataPtr();
+    indexType = GL_UNSIGNED_INT;
+    OVR::Array<uint16_t> narrowed;
+    if (vertexCount <= SHORT_INDEX_VERTEX_LIMIT) {
+      NarrowIndices(idc, narrowed);
+      indexData = narrowed.GetDataPtr();
+      indexType = GL_UNSIGNED_SHORT;
+    }
+
+    if (compact) {
+      CreateCompactBuffers(sources, layout.attributeCount, vertexCount, indexData, idc.GetSizeI());
+      // Only positions are needed from here on
+      vertices->normal.ClearAndRelease();
+      vertices->tangent.ClearAndRelease();
+      vertices->binormal.ClearAndRelease();
+      vertices->color.ClearAndRelease();
+      vertices->uv0.ClearAndRelease();
+      vertices->uv1.ClearAndRelease();
+      vertices->jointIndices.ClearAndRelease();
+      vertices->jointWeights.ClearAndRelease();
+    } else {
+      OVR::Array<float> data;
+      data.Resize(vertexCount * layout.stride);
+      for (int n = 0; n < layout.attributeCount; ++n) {
+        float* dst = data.GetDataPtr() + layout.offsets[n];
+        const float* src = sources[n].data;
+        for (int i = 0; i < vertexCount; ++i, dst += layout.stride, src += layout.components[n]) {
+          memcpy(dst, src, layout.components[n] * sizeof(float));
+        }
+      }
+      CreateBuffers(data.GetDataPtr(), data.GetSizeI() * sizeof(float), vertexCount, indexData, idc.GetSizeI(), NULL);
+    }
+  }
+
+  boundsVersion = 0;
+  dirtyStart = 0;
+  dirtyEnd = 0;
+  positionsDirty = false;
+  bvh = NULL;
+  collisionShape = NULL;
+  collisionShapeUsers = 0;
+}
+
+CoreGeometry::CoreGeometry(const VertexLayout& vertexLayout, const float* data, int vertexCount,
+                           const void* indexData, GLenum idxType, int indexCount, bool isDynamic, bool isCompact) {
+  layout = vertexLayout;
+  dynamic = isDynamic;
+  compact = isCompact && !isDynamic;
+  dequantize = OVR::Matrix4f::Identity();
+
+  // Bounds, picking and collisions only ever look at positions, so that's all
+  // we pull out of the interleaved data
+  vertices = new OVR::VertexAttribs();
+  int positionAttr = layout.Find(VERTEX_POSITION);
+  if (positionAttr != -1) {
+    vertices->position.Resize(vertexCount);
+    const float* src = data + layout.offsets[positionAttr];
+    for (int i = 0; i < vertexCount; ++i, src += layout.stride) {
+      vertices->position[i] = OVR::Vector3f(src[0], src[1], src[2]);
+    }
+  }
+  ComputeBounds();
+
+  indexType = idxType;
+  indices.Resize(indexCount);
+  if (indexType == GL_UNSIGNED_INT) {
+    memcpy(indices.GetDataPtr(), indexData, indexCount * sizeof(uint32_t));
+  } else {
+    const uint16_t* src = (const uint16_t*)indexData;
+    for (int i = 0; i < indexCount; ++i) {
+      indices[i] = src[i];
+    }
+  }
+
+  // 32-bit indices into few enough vertices get narrowed, halving the index
+  // buffer. Dynamic geometry keeps what it was given, since updateIndices
+  // takes the same type back.
+  OVR::Array<uint16_t> narrowed;
+  if (indexType == GL_UNSIGNED_INT && !dynamic && vertexCount <= SHORT_INDEX_VERTEX_LIMIT) {
+    NarrowIndices(indices, narrowed);
+    indexType = GL_UNSIGNED_SHORT;
+    indexData = narrowed.GetDataPtr();
+  }
+
+  if (compact) {
+    CompactSource sources[MAX_LAYOUT_ATTRIBUTES];
+    for (int a = 0; a < layout.attributeCount; ++a) {
+      sources[a].attribute = layout.attributes[a];
+      sources[a].data = data + layout.offsets[a];
+      sources[a].stride = layout.stride;
+    }
+    CreateCompactBuffers(sources, layout.attributeCount, vertexCount, indexData, indexCount);
+  } else {
+    // Spread dynamic vertices out into planar runs, so updating one attribute
+    // touches one contiguous range of the buffer. A run starts at vertexCount
+    // times the attribute's interleaved offset.
+    const float* upload = data;
+    if (dynamic) {
+      vertexShadow.Resize(vertexCount * layout.stride);
+      for (int a = 0; a < layout.attributeCount; ++a) {
+        float* dst = vertexShadow.GetDataPtr() + vertexCount * layout.offsets[a];
+        const float* src = data + layout.offsets[a];
+        for (int i = 0; i < vertexCount; ++i, src += layout.stride, dst += layout.components[a]) {
+          memcpy(dst, src, layout.components[a] * sizeof(float));
+        }
+      }
+      upload = vertexShadow.GetDataPtr();
+    }
+    CreateBuffers(upload, vertexCount * layout.stride * sizeof(float), vertexCount, indexData, indexCount, NULL);
+  }
+
+  boundsVersion = 0;
+  dirtyStart = 0;
+  dirtyEnd = 0;
+  positionsDirty = false;
+  bvh = NULL;
+  collisionShape = NULL;
+  collisionShapeUsers = 0;
+}
+
+// Quantizes positions against our bounds, so they need ComputeBounds first
+void CoreGeometry::CreateCompactBuffers(const CompactSource* sources, int sourceCount, int vertexCount,
+                                        const void* indexData, int indexCount) {
+  OVR::Vector3f center = (localBounds.GetMins() + localBounds.GetMaxs()) * 0.5f;
+  OVR::Vector3f halfSize = (localBounds.GetMaxs() - localBounds.GetMins()) * 0.5f;
+  float scale = OVR::Alg::Max(halfSize.x, OVR::Alg::Max(halfSize.y, halfSize.z));
+  if (scale <= 0.0f) {
+    scale = 1.0f;
+  }
+  dequantize = OVR::Matrix4f::Translation(center) * OVR::Matrix4f::Scaling(scale);
+
+  CompactLayout compactLayout;
+  OVR::Array<uint8_t> packed;
+  PackCompactVertices(sources, sourceCount, vertexCount, center, scale, &compactLayout, packed);
+  CreateBuffers(packed.GetDataPtr(), packed.GetSizeI(), vertexCount, indexData, indexCount, &compactLayout);
+}
+
+// Uploads vertices and indices of indexType into a fresh VAO. The vertices are
+// either packed as compactLayout says, or floats laid out by layout (planar
+// when dynamic).
+void CoreGeometry::CreateBuffers(const void* data, size_t vertexBytes, int vertexCount,
+                                 const void* indexData, int indexCount, const CompactLayout* compactLayout) {
+  GLenum usage = dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW;
+
+  geometry = new OVR::GlGeometry();
+  geometry->vertexCount = vertexCount;
+  geometry->indexCount = indexCount;
+
+  glGenVertexArrays(1, &geometry->vertexArrayObject);
+  glBindVertexArray(geometry->vertexArrayObject);
+
+  glGenBuffers(1, &geometry->vertexBuffer);
+  glBindBuffer(GL_ARRAY_BUFFER, geometry->vertexBuffer);
+  glBufferData(GL_ARRAY_BUFFER, vertexBytes, data, usage);
+  if (compactLayout != NULL) {
+    BindCompactAttributes(*compactLayout);
+  } else {
+    for (int i = 0; i < layout.attributeCount; ++i) {
+      // The VERTEX_* constants match the framework's attribute locations
+      GLsizei stride = (dynamic ? layout.components[i] : layout.stride) * sizeof(float);
+      size_t offset = (dynamic ? vertexCount * layout.offsets[i] : layout.offsets[i]) * sizeof(float);
+      glEnableVertexAttribArray(layout.attributes[i]);
+      glVertexAttribPointer(layout.attributes[i], layout.components[i], GL_FLOAT, GL_FALSE, stride, (const GLvoid*)offset);
+    }
+  }
+
+  glGenBuffers(1, &geometry->indexBuffer);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, geometry->indexBuffer);
+  size_t indexSize = indexType == GL_UNSIGNED_INT ? sizeof(uint32_t) : sizeof(uint16_t);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * indexSize, indexData, usage);
+
+  glBindVertexArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+// Writes count floats of attribute attr, starting at vertex offset. The caller
+// has checked the range.
+void CoreGeometry::UpdateVertices(int attr, int offset, const float* data, int count) {
+  int start = geometry->vertexCount * layout.offsets[attr] + offset * layout.components[attr];
+  memcpy(vertexShadow.GetDataPtr() + start, data, count * sizeof(float));
+  if (dirtyStart == dirtyEnd) {
+    dirtyStart = start;
+    dirtyEnd = start + count;
+  } else {
+    dirtyStart = OVR::Alg::Min(dirtyStart, start);
+    dirtyEnd = OVR::Alg::Max(dirtyEnd, start + count);
+  }
+  if (layout.attributes[attr] == VERTEX_POSITION) {
+    positionsDirty = true;
+  }
+}
+
+// Index updates are rare enough to go straight to GL. The data is in indexType.
+void CoreGeometry::UpdateIndices(int offset, const void* data, int count) {
+  size_t indexSize = indexType == GL_UNSIGNED_INT ? sizeof(uint32_t) : sizeof(uint16_t);
+  for (int i = 0; i < count; ++i) {
+    indices[offset + i] = indexType == GL_UNSIGNED_INT ? ((const uint32_t*)data)[i] : ((const uint16_t*)data)[i];
+  }
+
+  // The element binding belongs to the VAO, so go through ours
+  glBindVertexArray(geometry->vertexArrayObject);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, geometry->indexBuffer);
+  if (count == indices.GetSizeI()) {
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * indexSize, data, GL_DYNAMIC_DRAW);
+  } else {
+    glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, offset * indexSize, count * indexSize, data);
+  }
+  glBindVertexArray(0);
+
+  delete bvh;
+  bvh = NULL;
+}
+
+void CoreGeometry::Flush() {
+  if (dirtyStart == dirtyEnd) {
+    return;
+  }
+  glBindBuffer(GL_ARRAY_BUFFER, geometry->vertexBuffer);
+  int total = vertexShadow.GetSizeI();
+  if ((dirtyEnd - dirtyStart) * 2 >= total) {
+    // Most of it changed, so replace the whole store. The driver can hand us
+    // fresh memory instead of waiting on draws still reading the old one.
+    glBufferData(GL_ARRAY_BUFFER, total * sizeof(float), vertexShadow.GetDataPtr(), GL_DYNAMIC_DRAW);
+  } else {
+    glBufferSubData(GL_ARRAY_BUFFER, dirtyStart * sizeof(float), (dirtyEnd - dirtyStart) * sizeof(float),
+                    vertexShadow.GetDataPtr() + dirtyStart);
+  }
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  dirtyStart = dirtyEnd = 0;
+}
+
+void CoreGeometry::SyncPositions() {
+  if (!positionsDirty) {
+    return;
+  }
+  positionsDirty = false;
+  int attr = layout.Find(VERTEX_POSITION);
+  const float* src = vertexShadow.GetDataPtr() + geometry->vertexCount * layout.offsets[attr];
+  for (int i = 0; i < vertices->position.GetSizeI(); ++i, src += 3) {
+    vertices->position[i] = OVR::Vector3f(src[0], src[1], src[2]);
+  }
+  ComputeBounds();
+  ++boundsVersion;
+  delete bvh;
+  bvh = NULL;
+
+  if (collisionShape != NULL) {
+    if (collisionShapeUsers > 0) {
+      StaleShape stale = { collisionShape, collisionShapeUsers };
+      staleShapes.PushBack(stale);
+    } else {
+      delete collisionShape;
+    }
+    collisionShape = NULL;
+    collisionShapeUsers = 0;
+  }
 }
 
 CoreGeometry::~CoreGeometry(void) {
   geometry->Free();
   delete geometry;
   delete vertices;
+  delete bvh;
+  delete collisionShape;
+  for (int i = 0; i < staleShapes.GetSizeI(); ++i) {
+    delete staleShapes[i].shape;
+  }
+  for (int i = 0; i < collisionUsers.GetSizeI(); ++i) {
+    collisionUsers[i]->collisionGeometry = NULL;
+  }
+}
+
+void CoreGeometry::ComputeBounds() {
+  const OVR::Array<OVR::Vector3f>& positions = vertices->position;
+  if (positions.GetSizeI() == 0) {
+    localBounds = OVR::Bounds3f(OVR::Vector3f(0, 0, 0), OVR::Vector3f(0, 0, 0));
+    localCenter = OVR::Vector3f(0, 0, 0);
+    localRadius = 0.0f;
+    return;
+  }
+
+  localBounds = OVR::Bounds3f(positions[0], positions[0]);
+  for (int i = 1; i < positions.GetSizeI(); ++i) {
+    localBounds.AddPoint(positions[i]);
+  }
+
+  // Center the sphere on the box, but size it to the farthest vertex, which is
+  // usually a good deal tighter than the box's half diagonal
+  localCenter = (localBounds.GetMins() + localBounds.GetMaxs()) * 0.5f;
+  float radiusSq = 0.0f;
+  for (int i = 0; i < positions.GetSizeI(); ++i) {
+    radiusSq = OVR::Alg::Max(radiusSq, (positions[i] - localCenter).LengthSq());
+  }
+  localRadius = sqrtf(radiusSq);
+}
+
+bool CoreGeometry::IntersectRay(const OVR::Vector3f& origin, const OVR::Vector3f& dir, float& t) {
+  SyncPositions();
+  if (bvh == NULL) {
+    bvh = new TriangleBVH();
+    bvh->Build(vertices->position, indices);
+  }
+  return bvh->IntersectRay(origin, dir, vertices->position, indices, t);
+}
+
+static bool PositionLess(const OVR::Vector3f& a, const OVR::Vector3f& b) {
+  if (a.x != b.x) return a.x < b.x;
+  if (a.y != b.y) return a.y < b.y;
+  return a.z < b.z;
+}
+
+btCollisionShape* CoreGeometry::AcquireCollisionShape(CoreModel* user) {
+  SyncPositions();
+  collisionUsers.PushBack(user);
+  if (collisionShape != NULL) {
+    ++collisionShapeUsers;
+    return collisionShape;
+  }
+
+  // Shared vertices show up once per face in most meshes, so only hand the
+  // hull builder the unique ones
+  OVR::Array<OVR::Vector3f> unique(vertices->position);
+  if (unique.GetSizeI() > 0) {
+    OVR::Vector3f* begin = unique.GetDataPtr();
+    std::sort(begin, begin + unique.GetSizeI(), PositionLess);
+    unique.Resize(std::unique(begin, begin + unique.GetSizeI()) - begin);
+  }
+
+  btConvexHullShape* hull = new btConvexHullShape();
+  for (int i = 0; i < unique.GetSizeI(); ++i) {
+    hull->addPoint(btVector3(unique[i].x, unique[i].y, unique[i].z), false);
+  }
+  hull->recalcLocalAabb();
+
+  if (hull->getNumPoints() > COLLISION_HULL_MAX_VERTICES) {
+    btShapeHull simplifier(hull);
+    if (simplifier.buildHull(hull->getMargin())) {
+      btConvexHullShape* simplified = new btConvexHullShape(
+        (const btScalar*)simplifier.getVertexPointer(), simplifier.numVertices());
+      delete hull;
+      hull = simplified;
+    }
+  }
+
+  collisionShape = hull;
+  collisionShapeUsers = 1;
+  return collisionShape;
+}
+
+void CoreGeometry::ReleaseCollisionShape(CoreModel* user, btCollisionShape* shape) {
+  for (int i = 0; i < collisionUsers.GetSizeI(); ++i) {
+    if (collisionUsers[i] == user) {
+      collisionUsers.RemoveAt(i);
+      break;
+    }
+  }
+
+  if (shape == collisionShape) {
+    --collisionShapeUsers;
+    return;
+  }
+  for (int i = 0; i < staleShapes.GetSizeI(); ++i) {
+    if (staleShapes[i].shape == shape) {
+      if (--staleShapes[i].users == 0) {
+        delete shape;
+        staleShapes.RemoveAt(i);
+      }
+      return;
+    }
+  }
 }
 
 static JSClass coreGeometryClass = {
@@ -40,6 +478,84 @@ static JSPropertySpec CoreGeometry_props[] = {
   JS_PS_END
 };
 
+// Geometry({ layout, data, indices, dynamic, compact }): data is a Float32Array
+// of interleaved vertices laid out as layout says, and indices a Uint16Array or
+// Uint32Array. Both backing stores go straight to GL. Dynamic geometry can be
+// changed afterwards with update and updateIndices. Compact geometry is
+// quantized on the way (see CompactVertices.h) and can't also be dynamic.
+static CoreGeometry* NewTypedGeometry(JSContext* cx, JS::HandleObject opts, JS::HandleValue layoutVal) {
+  VertexLayout layout;
+  if (!ParseVertexLayout(cx, layoutVal, &layout)) {
+    return NULL;
+  }
+  if (layout.Find(VERTEX_POSITION) == -1) {
+    JS_ReportError(cx, "Expected layout to include VERTEX_POSITION");
+    return NULL;
+  }
+
+  JS::RootedValue dataVal(cx);
+  if (!JS_GetProperty(cx, opts, "data", &dataVal) || !dataVal.isObject() || !JS_IsFloat32Array(&dataVal.toObject())) {
+    JS_ReportError(cx, "Expected data to be a Float32Array");
+    return NULL;
+  }
+  JS::RootedValue indicesVal(cx);
+  if (!JS_GetProperty(cx, opts, "indices", &indicesVal) || !indicesVal.isObject()) {
+    JS_ReportError(cx, "Expected indices to be a Uint16Array or Uint32Array");
+    return NULL;
+  }
+  JS::RootedObject dataObj(cx, &dataVal.toObject());
+  JS::RootedObject indicesObj(cx, &indicesVal.toObject());
+  JS::RootedValue dynamicVal(cx);
+  if (!JS_GetProperty(cx, opts, "dynamic", &dynamicVal)) {
+    return NULL;
+  }
+  bool dynamic = JS::ToBoolean(dynamicVal);
+  JS::RootedValue compactVal(cx);
+  if (!JS_GetProperty(cx, opts, "compact", &compactVal)) {
+    return NULL;
+  }
+  bool compact = JS::ToBoolean(compactVal);
+  if (dynamic && compact) {
+    JS_ReportError(cx, "Geometry can't be both dynamic and compact");
+    return NULL;
+  }
+
+  // Nothing below can run script or GC, so the backing store pointers stay put
+  uint32_t dataLength;
+  float* data;
+  JS_GetObjectAsFloat32Array(dataObj, &dataLength, &data);
+  if (dataLength % layout.stride != 0) {
+    JS_ReportError(cx, "Data length %d isn't a multiple of the layout's %d floats per vertex", dataLength, layout.stride);
+    return NULL;
+  }
+  uint32_t vertexCount = dataLength / layout.stride;
+
+  uint32_t indexCount;
+  uint16_t* shortIndices = NULL;
+  uint32_t* intIndices = NULL;
+  if (JS_GetObjectAsUint16Array(indicesObj, &indexCount, &shortIndices) == NULL &&
+      JS_GetObjectAsUint32Array(indicesObj, &indexCount, &intIndices) == NULL) {
+    JS_ReportError(cx, "Expected indices to be a Uint16Array or Uint32Array");
+    return NULL;
+  }
+  if (indexCount % 3 != 0) {
+    JS_ReportError(cx, "Expected indices to describe whole triangles, got %d", indexCount);
+    return NULL;
+  }
+  for (uint32_t i = 0; i < indexCount; ++i) {
+    uint32_t index = intIndices != NULL ? intIndices[i] : shortIndices[i];
+    if (index >= vertexCount) {
+      JS_ReportError(cx, "Index %d at slot %d is out of range for %d vertices", index, i, vertexCount);
+      return NULL;
+    }
+  }
+
+  if (intIndices != NULL) {
+    return new CoreGeometry(layout, data, vertexCount, intIndices, GL_UNSIGNED_INT, indexCount, dynamic, compact);
+  }
+  return new CoreGeometry(layout, data, vertexCount, shortIndices, GL_UNSIGNED_SHORT, indexCount, dynamic, compact);
+}
+
 bool CoreGeometry_constructor(JSContext* cx, unsigned argc, JS::Value *vp) {
   JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
 
@@ -56,6 +572,21 @@ bool CoreGeometry_constructor(JSContext* cx, unsigned argc, JS::Value *vp) {
   }
   JS::RootedObject opts(cx, &args[0].toObject());
 
+  // Typed array geometry
+  JS::RootedValue layout(cx);
+  if (!JS_GetProperty(cx, opts, "layout", &layout)) {
+    return false;
+  }
+  if (!layout.isUndefined()) {
+    CoreGeometry* geometry = NewTypedGeometry(cx, opts, layout);
+    if (geometry == NULL) {
+      return false;
+    }
+    JS::RootedObject self(cx, NewCoreGeometry(cx, geometry));
+    args.rval().set(JS::ObjectOrNullValue(self));
+    return true;
+  }
+
   // Vertices
   JS::RootedValue vertices(cx);
   if (!JS_GetProperty(cx, opts, "vertices", &vertices) || vertices.isNullOrUndefined() || !vertices.isObject()) {
@@ -93,8 +624,8 @@ bool CoreGeometry_constructor(JSContext* cx, unsigned argc, JS::Value *vp) {
     JS_ReportError(cx, "Couldn't get indices array length");
     return false;
   }
-  // Fill a TriangleIndex array with the ints
-  OVR::Array<OVR::TriangleIndex> idc;
+  // Fill an index array with the ints
+  OVR::Array<uint32_t> idc;
   idc.Resize(indexLength);
   JS::RootedValue index(cx);
   for (size_t i = 0; i < indexLength; ++i) {
@@ -106,13 +637,112 @@ bool CoreGeometry_constructor(JSContext* cx, unsigned argc, JS::Value *vp) {
   }
 
   // Now we create our geometry
-  JS::RootedObject self(cx, NewCoreGeometry(cx, new CoreGeometry(vert, idc)));
+  JS::RootedObject self(cx, NewCoreGeometry(cx, new CoreGeometry(vert, idc, false)));
 
   // Return our self object
   args.rval().set(JS::ObjectOrNullValue(self));
   return true;
 }
 
+// geometry.update(attribute, offset, Float32Array) overwrites one attribute of
+// the vertices from offset onwards
+bool CoreGeometry_update(JSContext* cx, unsigned argc, JS::Value *vp) {
+  JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
+
+  if (args.length() != 3) {
+    JS_ReportError(cx, "Wrong number of arguments: %d, was expecting: %d", argc, 3);
+    return false;
+  }
+  JS::RootedObject self(cx, &args.thisv().toObject());
+  CoreGeometry* geometry = GetCoreGeometry(self);
+  if (geometry == NULL || !geometry->dynamic) {
+    JS_ReportError(cx, "Only geometry created with dynamic: true can be updated");
+    return false;
+  }
+  int attr = args[0].isInt32() ? geometry->layout.Find(args[0].toInt32()) : -1;
+  if (attr == -1) {
+    JS_ReportError(cx, "Expected the first argument to be a vertex constant from the geometry's layout");
+    return false;
+  }
+  if (!args[1].isInt32() || args[1].toInt32() < 0) {
+    JS_ReportError(cx, "Expected the second argument to be a vertex offset");
+    return false;
+  }
+  int offset = args[1].toInt32();
+
+  uint32_t length;
+  float* data;
+  if (!args[2].isObject() || JS_GetObjectAsFloat32Array(&args[2].toObject(), &length, &data) == NULL) {
+    JS_ReportError(cx, "Expected the third argument to be a Float32Array");
+    return false;
+  }
+  int components = geometry->layout.components[attr];
+  if (length % components != 0 || offset + (int)(length / components) > geometry->geometry->vertexCount) {
+    JS_ReportError(cx, "Update of %d floats at vertex %d doesn't fit the geometry", length, offset);
+    return false;
+  }
+
+  geometry->UpdateVertices(attr, offset, data, length);
+  args.rval().setUndefined();
+  return true;
+}
+
+// geometry.updateIndices(offset, indices) overwrites indices from offset
+// onwards. They have to be the same type the geometry was created with.
+bool CoreGeometry_updateIndices(JSContext* cx, unsigned argc, JS::Value *vp) {
+  JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
+
+  if (args.length() != 2) {
+    JS_ReportError(cx, "Wrong number of arguments: %d, was expecting: %d", argc, 2);
+    return false;
+  }
+  JS::RootedObject self(cx, &args.thisv().toObject());
+  CoreGeometry* geometry = GetCoreGeometry(self);
+  if (geometry == NULL || !geometry->dynamic) {
+    JS_ReportError(cx, "Only geometry created with dynamic: true can be updated");
+    return false;
+  }
+  if (!args[0].isInt32() || args[0].toInt32() < 0) {
+    JS_ReportError(cx, "Expected the first argument to be an index offset");
+    return false;
+  }
+  int offset = args[0].toInt32();
+
+  uint32_t length = 0;
+  uint16_t* shortIndices = NULL;
+  uint32_t* intIndices = NULL;
+  const void* data = NULL;
+  if (args[1].isObject()) {
+    JSObject* indicesObj = &args[1].toObject();
+    if (geometry->indexType == GL_UNSIGNED_INT && JS_GetObjectAsUint32Array(indicesObj, &length, &intIndices) != NULL) {
+      data = intIndices;
+    } else if (geometry->indexType == GL_UNSIGNED_SHORT && JS_GetObjectAsUint16Array(indicesObj, &length, &shortIndices) != NULL) {
+      data = shortIndices;
+    }
+  }
+  if (data == NULL) {
+    JS_ReportError(cx, "Expected the second argument to be a %s",
+                   geometry->indexType == GL_UNSIGNED_INT ? "Uint32Array" : "Uint16Array");
+    return false;
+  }
+  if (offset + (int)length > geometry->indices.GetSizeI()) {
+    JS_ReportError(cx, "Update of %d indices at %d doesn't fit the geometry", length, offset);
+    return false;
+  }
+  int vertexCount = geometry->geometry->vertexCount;
+  for (uint32_t i = 0; i < length; ++i) {
+    uint32_t index = intIndices != NULL ? intIndices[i] : shortIndices[i];
+    if (index >= (uint32_t)vertexCount) {
+      JS_ReportError(cx, "Index %d at slot %d is out of range for %d vertices", index, i, vertexCount);
+      return false;
+    }
+  }
+
+  geometry->UpdateIndices(offset, data, length);
+  args.rval().setUndefined();
+  return true;
+}
+
 void CoreGeometry_finalize(JSFreeOp *fop, JSObject *obj) {
   CoreGeometry* geometry = (CoreGeometry*)JS_GetPrivate(obj);
   JS_SetPrivate(obj, NULL);
@@ -124,23 +754,32 @@ void CoreGeometry_trace(JSTracer *tracer, JSObject *obj) {
   __android_log_print(ANDROID_LOG_DEBUG, LOG_COMPONENT, "Finished tracing geometry\n");
 }
 
+static JS::PersistentRootedObject coreGeometryProto;
+
+static JSFunctionSpec CoreGeometry_methods[] = {
+  JS_FN("update", CoreGeometry_update, 3, 0),
+  JS_FN("updateIndices", CoreGeometry_updateIndices, 2, 0),
+  JS_FS_END
+};
+
 void SetupCoreGeometry(JSContext* cx, JS::RootedObject *global, JS::RootedObject *core) {
   coreGeometryClass.finalize = CoreGeometry_finalize;
   JSObject *obj = JS_InitClass(
       cx,
       *core,
-      *global,
+      nullptr,
       &coreGeometryClass,
       CoreGeometry_constructor,
       1,
-      nullptr, /* Properties */
-      nullptr, /* Methods */
+      CoreGeometry_props, /* Properties */
+      CoreGeometry_methods, /* Methods */
       nullptr, /* Static Props */
       nullptr  /* Static Methods */);
   if (!obj) {
     __android_log_print(ANDROID_LOG_ERROR, LOG_COMPONENT, "Could not construct env.core.Geometry class\n");
     return;
   }
+  coreGeometryProto.init(cx, obj);
 
   // Now attach our constants for VERTEX_*
   if (!JS_SetProperty(cx, *core, "VERTEX_POSITION", JS::RootedValue(cx, JS::NumberValue(VERTEX_POSITION)))) {
@@ -182,15 +821,16 @@ void SetupCoreGeometry(JSContext* cx, JS::RootedObject *global, JS::RootedObject
 }
 
 JSObject* NewCoreGeometry(JSContext* cx, CoreGeometry* geometry) {
-  JS::RootedObject self(cx, JS_NewObject(cx, &coreGeometryClass));
-  if (!JS_DefineProperties(cx, self, CoreGeometry_props)) {
-    __android_log_print(ANDROID_LOG_ERROR, LOG_COMPONENT, "Could not define properties on geometry\n");
-  }
+  JS::RootedObject self(cx, JS_NewObjectWithGivenProto(cx, &coreGeometryClass, coreGeometryProto));
   JS_SetPrivate(self, (void *)geometry);
   return self;
 }
 
 CoreGeometry* GetCoreGeometry(JS::HandleObject obj) {
+  // The prototype and objects of other classes have no payload for us
+  if (JS_GetClass(obj) != &coreGeometryClass) {
+    return NULL;
+  }
   CoreGeometry* geometry = (CoreGeometry*)JS_GetPrivate(obj);
   return geometry;
 }
\ No newline at end of file
@@ -3,20 +3,91 @@
 
 #include "BaseInclude.h"
 #include "ParseVertexAttribs.h"
+#include "TriangleBVH.h"
+#include "CompactVertices.h"
+
+class CoreModel;
+
+// Meshes with at most this many vertices get 16-bit indices
+const static int SHORT_INDEX_VERTEX_LIMIT = 65536;
 
 class CoreGeometry {
 public:
   OVR::GlGeometry* geometry;
-  OVR::VertexAttribs* vertices;
-  OVR::Array<OVR::TriangleIndex> indices;
+  OVR::VertexAttribs* vertices; // Only positions, when built from typed arrays
+  OVR::Array<uint32_t> indices; // Kept for picking and collision shapes
+  GLenum indexType; // What the index buffer holds, GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+
+  // Model space bounds of the vertex positions
+  OVR::Bounds3f localBounds;
+  OVR::Vector3f localCenter;
+  float localRadius;
+  int boundsVersion; // Bumped whenever the bounds move, so models know to refresh theirs
+
+  // Dynamic geometry keeps its vertices planar, each attribute's run after the
+  // last, with a shadow copy that updates land in. Flush uploads whatever
+  // changed once per frame, and the positions, bounds and BVH catch up the
+  // next time something asks for them. That also retires the collision hull,
+  // and models rebuild theirs once they see boundsVersion move.
+  bool dynamic;
+  VertexLayout layout;
+  OVR::Array<float> vertexShadow;
+
+  // Compact geometry stores quantized vertices (see CompactVertices.h), whose
+  // positions only come out right through dequantize. Draws fold it into the
+  // model matrix.
+  bool compact;
+  OVR::Matrix4f dequantize;
 
-  CoreGeometry(OVR::VertexAttribs* vert, OVR::Array<OVR::TriangleIndex> idc);
+  // Picks 16-bit indices when the vertex count allows, otherwise 32-bit
+  CoreGeometry(OVR::VertexAttribs* vert, const OVR::Array<uint32_t>& idc, bool isCompact);
+  // Uploads interleaved float vertices and the index data as they are, without
+  // going through VertexAttribs. The data only has to live through the call.
+  CoreGeometry(const VertexLayout& vertexLayout, const float* data, int vertexCount,
+               const void* indexData, GLenum idxType, int indexCount, bool isDynamic, bool isCompact);
   ~CoreGeometry();
+  void ComputeBounds();
+  void UpdateVertices(int attr, int offset, const float* data, int count);
+  void UpdateIndices(int offset, const void* data, int count);
+  void Flush();
+  void SyncPositions();
+  bool IntersectRay(const OVR::Vector3f& origin, const OVR::Vector3f& dir, float& t);
+  // The hull is built on first use and shared. Each acquire needs a release
+  // by the same model with the same shape, which may have been retired since.
+  btCollisionShape* AcquireCollisionShape(CoreModel* user);
+  void ReleaseCollisionShape(CoreModel* user, btCollisionShape* shape);
+
+private:
+  void CreateCompactBuffers(const CompactSource* sources, int sourceCount, int vertexCount,
+                            const void* indexData, int indexCount);
+  void CreateBuffers(const void* data, size_t vertexBytes, int vertexCount,
+                     const void* indexData, int indexCount, const CompactLayout* compactLayout);
+
+  int dirtyStart; // Range of vertexShadow floats that haven't been uploaded yet
+  int dirtyEnd;
+  bool positionsDirty;
+  TriangleBVH* bvh; // Built the first time something picks against us
+  btCollisionShape* collisionShape; // Shared by every model colliding with this geometry
+  int collisionShapeUsers;
+
+  // Hulls retired by moved positions, kept until their last model lets go
+  struct StaleShape {
+    btCollisionShape* shape;
+    int users;
+  };
+  OVR::Array<StaleShape> staleShapes;
+
+  // Models holding one of our hulls. A model and its geometry can be finalized
+  // in the same sweep in either order, so we clear their collisionGeometry
+  // when we go first, and they release their hull when they do.
+  OVR::Array<CoreModel*> collisionUsers;
 };
 
 void SetupCoreGeometry(JSContext* cx, JS::RootedObject *global, JS::RootedObject *core);
 JSObject* NewCoreGeometry(JSContext* cx, CoreGeometry* geometry);
 CoreGeometry* GetCoreGeometry(JS::HandleObject obj);
+bool CoreGeometry_update(JSContext* cx, unsigned argc, JS::Value *vp);
+bool CoreGeometry_updateIndices(JSContext* cx, unsigned argc, JS::Value *vp);
 void CoreGeometry_finalize(JSFreeOp *fop, JSObject *obj);
 void CoreGeometry_trace(JSTracer *tracer, JSObject *obj);
 
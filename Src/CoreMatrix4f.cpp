@@ -1,9 +1,10 @@
 #include "CoreMatrix4f.h"
+#include "MathPool.h"
 
 
 static JSClass coreMatrix4fClass = {
   "Matrix4f",             /* name */
-  JSCLASS_HAS_PRIVATE,    /* flags */
+  JSCLASS_HAS_PRIVATE | JSCLASS_HAS_RESERVED_SLOTS(1), /* flags */
   NULL,
   NULL,
   NULL,
@@ -14,37 +15,29 @@ static JSClass coreMatrix4fClass = {
   CoreMatrix4f_finalize
 };
 
-JSObject* NewCoreMatrix4f(JSContext* cx, OVR::Matrix4f* matrix4f) {
-  JS::RootedObject self(cx, JS_NewObject(cx, &coreMatrix4fClass));
-  if (!JS_DefineFunction(cx, self, "setTranslation", &CoreMatrix4f_setTranslation, 0, 0)) {
-    JS_ReportError(cx, "Could not create matrix4f.setTranslation function");
-    return NULL;
-  }
-  if (!JS_DefineFunction(cx, self, "multiply", &CoreMatrix4f_multiply, 0, 0)) {
-    JS_ReportError(cx, "Could not create matrix4f.multiply function");
-    return NULL;
-  }
-  if (!JS_DefineFunction(cx, self, "rotationX", &CoreMatrix4f_rotationX, 0, 0)) {
-    JS_ReportError(cx, "Could not create matrix4f.rotationX function");
-    return NULL;
-  }
-  if (!JS_DefineFunction(cx, self, "rotationY", &CoreMatrix4f_rotationY, 0, 0)) {
-    JS_ReportError(cx, "Could not create matrix4f.rotationY function");
-    return NULL;
-  }
-  if (!JS_DefineFunction(cx, self, "rotationZ", &CoreMatrix4f_rotationZ, 0, 0)) {
-    JS_ReportError(cx, "Could not create matrix4f.rotationZ function");
-    return NULL;
-  }
-  if (!JS_DefineFunction(cx, self, "transform", &CoreMatrix4f_transform, 0, 0)) {
-    JS_ReportError(cx, "Could not create matrix4f.transform function");
-    return NULL;
-  }
-  JS_SetPrivate(self, (void *)matrix4f);
+static JS::PersistentRootedObject coreMatrix4fProto;
+
+static JSFunctionSpec CoreMatrix4f_methods[] = {
+  JS_FN("setTranslation", CoreMatrix4f_setTranslation, 0, 0),
+  JS_FN("multiply", CoreMatrix4f_multiply, 0, 0),
+  JS_FN("rotationX", CoreMatrix4f_rotationX, 0, 0),
+  JS_FN("rotationY", CoreMatrix4f_rotationY, 0, 0),
+  JS_FN("rotationZ", CoreMatrix4f_rotationZ, 0, 0),
+  JS_FN("transform", CoreMatrix4f_transform, 0, 0),
+  JS_FS_END
+};
+
+JSObject* NewCoreMatrix4f(JSContext* cx, const OVR::Matrix4f& matrix4f) {
+  JS::RootedObject self(cx, JS_NewObjectWithGivenProto(cx, &coreMatrix4fClass, coreMatrix4fProto));
+  JS_SetPrivate(self, (void *)Matrix4fPool.New(matrix4f));
   return self;
 }
 
 OVR::Matrix4f* GetMatrix4f(JS::HandleObject obj) {
+  // The prototype and objects of other classes have no payload for us
+  if (JS_GetClass(obj) != &coreMatrix4fClass) {
+    return NULL;
+  }
   OVR::Matrix4f* matrix4f = (OVR::Matrix4f*)JS_GetPrivate(obj);
   return matrix4f;
 }
@@ -52,8 +45,7 @@ OVR::Matrix4f* GetMatrix4f(JS::HandleObject obj) {
 bool CoreMatrix4f_constructor(JSContext* cx, unsigned argc, JS::Value *vp) {
   JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
 
-  OVR::Matrix4f* matrix4f = new OVR::Matrix4f();
-  JS::RootedObject self(cx, NewCoreMatrix4f(cx, matrix4f));
+  JS::RootedObject self(cx, NewCoreMatrix4f(cx, OVR::Matrix4f()));
 
   // Return our self object
   args.rval().set(JS::ObjectOrNullValue(self));
@@ -63,8 +55,7 @@ bool CoreMatrix4f_constructor(JSContext* cx, unsigned argc, JS::Value *vp) {
 void CoreMatrix4f_finalize(JSFreeOp *fop, JSObject *obj) {
   OVR::Matrix4f* matrix4f = (OVR::Matrix4f*)JS_GetPrivate(obj);
   JS_SetPrivate(obj, NULL);
-  // TODO: Figure out what to do about ownership of this value and whether to free it
-  delete matrix4f;
+  Matrix4fPool.Delete(matrix4f);
 }
 
 bool CoreMatrix4f_setTranslation(JSContext* cx, unsigned argc, JS::Value *vp) {
@@ -87,7 +78,11 @@ bool CoreMatrix4f_setTranslation(JSContext* cx, unsigned argc, JS::Value *vp) {
 
   JS::RootedObject thisObj(cx, &args.thisv().toObject());
   OVR::Matrix4f* mat = GetMatrix4f(thisObj);
+  if (mat == NULL) {
+    return ReportWrongThis(cx, "Matrix4f");
+  }
   mat->SetTranslation(*vec);
+  BumpChangeStamp(thisObj);
 
   return true;
 }
@@ -112,10 +107,12 @@ bool CoreMatrix4f_multiply(JSContext* cx, unsigned argc, JS::Value *vp) {
 
   JS::RootedObject thisObj(cx, &args.thisv().toObject());
   OVR::Matrix4f* mat = GetMatrix4f(thisObj);
+  if (mat == NULL) {
+    return ReportWrongThis(cx, "Matrix4f");
+  }
 
   // Do the multiplication
-  OVR::Matrix4f* res = new OVR::Matrix4f(*mat * *otherMat);
-  JS::RootedObject result(cx, NewCoreMatrix4f(cx, res));
+  JS::RootedObject result(cx, NewCoreMatrix4f(cx, *mat * *otherMat));
 
   args.rval().set(JS::ObjectOrNullValue(result));
   return true;
@@ -140,8 +137,10 @@ bool CoreMatrix4f_rotationX(JSContext* cx, unsigned argc, JS::Value *vp) {
 
   JS::RootedObject thisObj(cx, &args.thisv().toObject());
   OVR::Matrix4f* mat = GetMatrix4f(thisObj);
-  OVR::Matrix4f* res = new OVR::Matrix4f(mat->RotationX((float)deg));
-  JS::RootedObject result(cx, NewCoreMatrix4f(cx, res));
+  if (mat == NULL) {
+    return ReportWrongThis(cx, "Matrix4f");
+  }
+  JS::RootedObject result(cx, NewCoreMatrix4f(cx, mat->RotationX((float)deg)));
 
   args.rval().set(JS::ObjectOrNullValue(result));
   return true;
@@ -166,8 +165,10 @@ bool CoreMatrix4f_rotationY(JSContext* cx, unsigned argc, JS::Value *vp) {
 
   JS::RootedObject thisObj(cx, &args.thisv().toObject());
   OVR::Matrix4f* mat = GetMatrix4f(thisObj);
-  OVR::Matrix4f* res = new OVR::Matrix4f(mat->RotationY((float)deg));
-  JS::RootedObject result(cx, NewCoreMatrix4f(cx, res));
+  if (mat == NULL) {
+    return ReportWrongThis(cx, "Matrix4f");
+  }
+  JS::RootedObject result(cx, NewCoreMatrix4f(cx, mat->RotationY((float)deg)));
 
   args.rval().set(JS::ObjectOrNullValue(result));
   return true;
@@ -192,8 +193,10 @@ bool CoreMatrix4f_rotationZ(JSContext* cx, unsigned argc, JS::Value *vp) {
 
   JS::RootedObject thisObj(cx, &args.thisv().toObject());
   OVR::Matrix4f* mat = GetMatrix4f(thisObj);
-  OVR::Matrix4f* res = new OVR::Matrix4f(mat->RotationZ((float)deg));
-  JS::RootedObject result(cx, NewCoreMatrix4f(cx, res));
+  if (mat == NULL) {
+    return ReportWrongThis(cx, "Matrix4f");
+  }
+  JS::RootedObject result(cx, NewCoreMatrix4f(cx, mat->RotationZ((float)deg)));
 
   args.rval().set(JS::ObjectOrNullValue(result));
   return true;
@@ -219,9 +222,11 @@ bool CoreMatrix4f_transform(JSContext* cx, unsigned argc, JS::Value *vp) {
 
   JS::RootedObject thisObj(cx, &args.thisv().toObject());
   OVR::Matrix4f* mat = GetMatrix4f(thisObj);
+  if (mat == NULL) {
+    return ReportWrongThis(cx, "Matrix4f");
+  }
 
-  OVR::Vector3f* res = new OVR::Vector3f(mat->Transform(*vec));
-  JS::RootedObject result(cx, NewCoreVector3f(cx, res));
+  JS::RootedObject result(cx, NewCoreVector3f(cx, mat->Transform(*vec)));
 
   args.rval().set(JS::ObjectOrNullValue(result));
   return true;
@@ -231,18 +236,19 @@ void SetupCoreMatrix4f(JSContext* cx, JS::RootedObject *global, JS::RootedObject
   JSObject *obj = JS_InitClass(
       cx,
       *core,
-      *global,
+      nullptr,
       &coreMatrix4fClass,
       CoreMatrix4f_constructor,
       3,
       nullptr, /* Properties */
-      nullptr, /* Methods */
+      CoreMatrix4f_methods, /* Methods */
       nullptr, /* Static Props */
       nullptr  /* Static Methods */);
   if (!obj) {
     __android_log_print(ANDROID_LOG_ERROR, LOG_COMPONENT, "Could not construct env.core.Matrix4f class\n");
     return;
   }
+  coreMatrix4fProto.init(cx, obj);
 }
 
 const JSClass* CoreMatrix4f_class() {
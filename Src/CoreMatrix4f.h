@@ -5,7 +5,7 @@
 #include "CoreVector3f.h"
 
 void SetupCoreMatrix4f(JSContext* cx, JS::RootedObject *global, JS::RootedObject *core);
-JSObject* NewCoreMatrix4f(JSContext* cx, OVR::Matrix4f* matrix4f);
+JSObject* NewCoreMatrix4f(JSContext* cx, const OVR::Matrix4f& matrix4f);
 OVR::Matrix4f* GetMatrix4f(JS::HandleObject obj);
 
 bool CoreMatrix4f_setTranslation(JSContext* cx, unsigned argc, JS::Value *vp);
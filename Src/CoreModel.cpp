@@ -9,11 +9,39 @@ CoreModel::CoreModel(void) :
   isTouching(false),
   textSize(12.0f),
   textOutlineSize(0.0f),
+  splitLargeMeshes(false),
+  compactVertices(false),
   localMatrix(),
-  worldMatrix() {
+  worldMatrix(),
+  worldCenter(0, 0, 0),
+  worldRadius(-1.0f),
+  boundsGeometry(NULL),
+  boundsVersion(0),
+  boundsHaveText(false),
+  gazeLeaf(NULL),
+  gazeBoundsDirty(true),
+  textMetricsValid(false),
+  textWidth(0.0f),
+  textHeight(0.0f),
+  transformDirty(true),
+  matrixStamp(0),
+  positionStamp(0),
+  rotationStamp(0),
+  scaleStamp(0) {
   id = CURRENT_MODEL_ID++;
+  graphIndex = -1;
+  parent = NULL;
+  childIndex = -1;
   collisionShape = NULL;
   collisionObj = NULL;
+  collisionGeometryVal = NULL;
+  collisionGeometry = NULL;
+  collisionVersion = 0;
+  collisionGroup = 0;
+  collisionMask = 0;
+  collisionType = COLLISION_KINEMATIC;
+  collisionTransformDirty = true;
+  collisionOverlapping = false;
   texturesVal = NULL;
   textVal = NULL;
   textColorVal = NULL;
@@ -52,6 +80,8 @@ CoreModel::~CoreModel(void) {
   delete onGestureTouchCancelVal;
   delete onCollideStartVal;
   delete onCollideEndVal;
+  // Hands the hull back, unless the geometry was finalized before us and has
+  // already cleared collisionGeometry
   StopCollisions();
 }
 
@@ -64,14 +94,58 @@ void CoreModel::AddModel(JSContext* cx, JS::HandleObject otherModelObj) {
     otherModel->programVal = new JS::Heap<JS::Value>(prog);
   }
 
-  // Annotate the scene object on the model
-  otherModel->scene = scene;
-
-  // Make sure collision detection is runninggeom->indexCount
-  otherModel->StartCollisions(cx);
+  // A model only hangs in one place, so take it out of its old one first
+  otherModel->Unlink(cx);
 
+  // Link it in, and index it (and anything below it) if we're in a scene
+  otherModel->parent = this;
+  otherModel->childIndex = children.GetSizeI();
   JS::RootedValue otherModelVal(cx, JS::ObjectOrNullValue(otherModelObj));
   children.PushBack(JS::Heap<JS::Value>(otherModelVal));
+
+  if (scene != NULL) {
+    scene->RegisterModel(cx, otherModel);
+    scene->graph.MarkDirty();
+
+    // Make sure collision detection is running
+    otherModel->StartCollisions(cx);
+  }
+}
+
+// Takes us out of our parent or scene, along with everything below us. Returns
+// false if we weren't linked anywhere.
+bool CoreModel::Unlink(JSContext* cx) {
+  if (scene != NULL) {
+    return scene->RemoveModel(cx, this);
+  }
+  if (parent != NULL) {
+    return SwapRemoveChild(cx, parent->children, this);
+  }
+  return false;
+}
+
+bool SwapRemoveChild(JSContext* cx, OVR::Array<JS::Heap<JS::Value>>& siblings, CoreModel* model) {
+  int idx = model->childIndex;
+  if (idx < 0 || idx >= siblings.GetSizeI()) {
+    return false;
+  }
+  JS::RootedObject childObj(cx, &siblings[idx].toObject());
+  if (GetCoreModel(childObj) != model) {
+    return false;
+  }
+
+  // Move the last sibling into the hole rather than shifting everything down
+  int last = siblings.GetSizeI() - 1;
+  if (idx != last) {
+    siblings[idx] = siblings[last];
+    JS::RootedObject movedObj(cx, &siblings[idx].toObject());
+    GetCoreModel(movedObj)->childIndex = idx;
+  }
+  siblings.PopBack();
+
+  model->parent = NULL;
+  model->childIndex = -1;
+  return true;
 }
 
 static JSClass coreModelClass = {
@@ -91,71 +165,168 @@ static JSClass coreModelClass = {
   CoreModel_trace
 };
 
-bool CoreModel::RemoveModel(JSContext* cx, CoreModel* model) {
-  // Find the index of the model to remove
-  int idx = -1;
-  for (int i = 0; i < children.GetSizeI(); ++i) {
-    JS::RootedObject childObj(cx, &children[i].toObject());
-    CoreModel* child = GetCoreModel(childObj);
-    if (child->id == model->id) {
-      idx = i;
-      break;
-    }
-  }
+bool CoreModel::MarkTransformDirty() {
+  transformDirty = true;
+  return true;
+}
 
-  // If we found it, remove it
-  if (idx != -1) {
-    children.RemoveAt(idx);
-    return true;
+static bool RefreshChangeStamp(JS::Heap<JS::Value>* val, int32_t* stamp) {
+  if (!ValueDefined(val)) {
+    return false;
   }
-
-  // Otherwise, recurse
-  for (int i = 0; i < children.GetSizeI(); ++i) {
-    JS::RootedObject childObj(cx, &children[i].toObject());
-    CoreModel* child = GetCoreModel(childObj);
-    if (child->RemoveModel(cx, model)) {
-      return true;
-    }
+  int32_t current = GetChangeStamp(&val->toObject());
+  if (current == *stamp) {
+    return false;
   }
-
-  return false;
+  *stamp = current;
+  return true;
 }
 
-void CoreModel::ComputeMatrices(JSContext* cx, OVR::Matrix4f& transform) {
-  OVR::Matrix4f mtx;
+bool CoreModel::TransformChanged() {
+  // Check every stamp (no short circuit) so they're all current afterwards
+  bool changed = transformDirty;
+  changed = RefreshChangeStamp(matrixVal, &matrixStamp) || changed;
+  changed = RefreshChangeStamp(positionVal, &positionStamp) || changed;
+  changed = RefreshChangeStamp(rotationVal, &rotationStamp) || changed;
+  changed = RefreshChangeStamp(scaleVal, &scaleStamp) || changed;
+  transformDirty = false;
+  return changed;
+}
 
+void CoreModel::GatherTransform(JSContext* cx, TransformSoA& trs, int idx) {
   OVR::Matrix4f* mat = matrix(cx);
-  if (mat != NULL) {
-    mtx = *mat;
-  }
+  trs.base[idx] = mat != NULL ? *mat : OVR::Matrix4f();
 
   OVR::Vector3f* rot = rotation(cx);
-  if (rot != NULL) {
-    mtx *= (
-      OVR::Matrix4f::RotationX(rot->x) *
-      OVR::Matrix4f::RotationY(rot->y) *
-      OVR::Matrix4f::RotationZ(rot->z)
-    );
-  }
+  trs.rotX[idx] = rot != NULL ? rot->x : 0.0f;
+  trs.rotY[idx] = rot != NULL ? rot->y : 0.0f;
+  trs.rotZ[idx] = rot != NULL ? rot->z : 0.0f;
 
   OVR::Vector3f* scl = scale(cx);
-  if (scl != NULL) {
-    mtx *= OVR::Matrix4f::Scaling(*scl);
+  trs.sclX[idx] = scl != NULL ? scl->x : 1.0f;
+  trs.sclY[idx] = scl != NULL ? scl->y : 1.0f;
+  trs.sclZ[idx] = scl != NULL ? scl->z : 1.0f;
+
+  // Without a position the matrix keeps its own translation
+  OVR::Vector3f pos = trs.base[idx].GetTranslation();
+  OVR::Vector3f* posPtr = position(cx);
+  if (posPtr != NULL) {
+    pos = *posPtr;
+  }
+  trs.posX[idx] = pos.x;
+  trs.posY[idx] = pos.y;
+  trs.posZ[idx] = pos.z;
+}
+
+void CoreModel::UpdateWorldBounds(JSContext* cx, bool worldChanged) {
+  CoreGeometry* geom = ValueDefined(geometryVal) ? geometry(cx) : NULL;
+  int geomBoundsVersion = 0;
+  if (geom != NULL) {
+    geom->SyncPositions();
+    geomBoundsVersion = geom->boundsVersion;
+  }
+  bool hasText = ValueDefined(textVal);
+  if (!worldChanged && geom == boundsGeometry && geomBoundsVersion == boundsVersion && hasText == boundsHaveText) {
+    return;
   }
+  boundsGeometry = geom;
+  boundsVersion = geomBoundsVersion;
+  boundsHaveText = hasText;
+  gazeBoundsDirty = true;
+
+  if (geom == NULL) {
+    worldCenter = worldMatrix.GetTranslation();
+    worldRadius = -1.0f;
+    geometryBounds = OVR::Bounds3f(worldCenter, worldCenter);
+  } else {
+    geometryBounds = TransformBounds(geom->localBounds);
 
-  OVR::Vector3f* pos = position(cx);
-  if (pos != NULL) {
-    mtx.SetTranslation(*pos);
+    // The sphere grows by the largest axis scale
+    float scaleSq = 0.0f;
+    for (int c = 0; c < 3; ++c) {
+      OVR::Vector3f axis(worldMatrix.M[0][c], worldMatrix.M[1][c], worldMatrix.M[2][c]);
+      scaleSq = OVR::Alg::Max(scaleSq, axis.LengthSq());
+    }
+    worldCenter = worldMatrix.Transform(geom->localCenter);
+    worldRadius = geom->localRadius * sqrtf(scaleSq);
   }
 
-  localMatrix = mtx;
-  worldMatrix = transform * mtx;
+  if (hasText) {
+    worldRadius = FLT_MAX;
+  }
+}
 
-  for (int i = 0; i < children.GetSizeI(); ++i) {
-    JS::RootedObject childObj(cx, &children[i].toObject());
-    CoreModel* child = GetCoreModel(childObj);
-    child->ComputeMatrices(cx, worldMatrix);
+OVR::Bounds3f CoreModel::TransformBounds(const OVR::Bounds3f& local) {
+  // Transform the box by projecting each axis's extent (Arvo's method)
+  const OVR::Vector3f& mins = local.GetMins();
+  const OVR::Vector3f& maxs = local.GetMaxs();
+  OVR::Vector3f newMins = worldMatrix.GetTranslation();
+  OVR::Vector3f newMaxs = newMins;
+  for (int r = 0; r < 3; ++r) {
+    for (int c = 0; c < 3; ++c) {
+      float a = worldMatrix.M[r][c] * mins[c];
+      float b = worldMatrix.M[r][c] * maxs[c];
+      newMins[r] += OVR::Alg::Min(a, b);
+      newMaxs[r] += OVR::Alg::Max(a, b);
+    }
+  }
+  return OVR::Bounds3f(newMins, newMaxs);
+}
+
+bool CoreModel::InvalidateText() {
+  textMetricsValid = false;
+  gazeBoundsDirty = true;
+  return true;
+}
+
+bool CoreModel::GetTextMetrics(JSContext* cx, OVR::OvrGuiSys* guiSys, float& width, float& height) {
+  if (!textMetricsValid) {
+    OVR::String txtStr;
+    JS::RootedValue t(cx, *textVal);
+    if (!GetOVRStringVal(cx, t, &txtStr)) {
+      JS_ReportError(cx, "Could not get string data from text string");
+      return false;
+    }
+
+    // Get metrics from the text (width/height is all we care about for now)
+    size_t txtLen;
+    float txtAscent;
+    float txtDescent;
+    float txtFontHeight;
+    int const TXT_MAX_LINES = 128;
+    float txtLineWidths[TXT_MAX_LINES];
+    int txtNumLines;
+    guiSys->GetDefaultFont().CalcTextMetrics(txtStr.ToCStr(), txtLen,
+      textWidth, textHeight, txtAscent, txtDescent, txtFontHeight,
+      txtLineWidths, TXT_MAX_LINES, txtNumLines);
+    textMetricsValid = true;
+  }
+  width = textWidth * textSize;
+  height = textHeight * textSize;
+  return true;
+}
+
+bool CoreModel::UpdateGazeBounds(JSContext* cx, OVR::OvrGuiSys* guiSys) {
+  gazeBoundsDirty = false;
+  bool hasBounds = false;
+  if (boundsGeometry != NULL) {
+    gazeBounds = geometryBounds;
+    hasBounds = true;
   }
+  if (ValueDefined(textVal)) {
+    float width, height;
+    if (GetTextMetrics(cx, guiSys, width, height)) {
+      OVR::Bounds3f textBounds = TransformBounds(OVR::Bounds3f(OVR::Vector3f(0, 0, 0), OVR::Vector3f(width, height, 0)));
+      if (hasBounds) {
+        gazeBounds.AddPoint(textBounds.GetMins());
+        gazeBounds.AddPoint(textBounds.GetMaxs());
+      } else {
+        gazeBounds = textBounds;
+      }
+      hasBounds = true;
+    }
+  }
+  return hasBounds;
 }
 
 void CoreModel::CallFrameCallbacks(JSContext* cx, JS::HandleValue ev) {
@@ -168,12 +339,6 @@ void CoreModel::CallFrameCallbacks(JSContext* cx, JS::HandleValue ev) {
       __android_log_print(ANDROID_LOG_ERROR, LOG_COMPONENT, "Could not call onFrame callback\n");
     }
   }
-
-  for (int i = 0; i < children.GetSizeI(); ++i) {
-    JS::RootedObject childObj(cx, &children[i].toObject());
-    CoreModel* child = GetCoreModel(childObj);
-    child->CallFrameCallbacks(cx, ev);
-  }
 }
 
 void CoreModel::CallGazeCallbacks(JSContext* cx, OVR::OvrGuiSys* guiSys, OVR::Vector3f* viewPos, OVR::Vector3f* viewFwd, const OVR::VrFrame& vrFrame, JS::HandleValue ev) {
@@ -186,55 +351,27 @@ void CoreModel::CallGazeCallbacks(JSContext* cx, OVR::OvrGuiSys* guiSys, OVR::Ve
 
     bool foundIntersection = false;
 
-    // First check for intersection via the regular geometry
+    // First check for intersection via the regular geometry, by taking the
+    // ray into model space rather than the vertices into world space
     if (ValueDefined(geometryVal)) {
       CoreGeometry* geom = geometry(cx);
-      OVR::Array<OVR::Vector3f> vertices = geom->vertices->position;
-      for (int j = 0; j < geom->indices.GetSizeI(); j += 3) {
-        OVR::Vector3f v0 = worldMatrix.Transform(vertices[geom->indices[j]]);
-        OVR::Vector3f v1 = worldMatrix.Transform(vertices[geom->indices[j + 1]]);
-        OVR::Vector3f v2 = worldMatrix.Transform(vertices[geom->indices[j + 2]]);
-        float t0, u, v;
-        if (OVR::Intersect_RayTriangle(*viewPos, *viewFwd, v0, v1, v2, t0, u, v)) {
-          foundIntersection = true;
-          break;
-        }
-        // Check the backface
-        if (OVR::Intersect_RayTriangle(*viewPos, *viewFwd, v2, v1, v0, t0, u, v)) {
-          foundIntersection = true;
-          break;
-        }
+      OVR::Matrix4f invWorld = worldMatrix.Inverted();
+      OVR::Vector3f localPos = invWorld.Transform(*viewPos);
+      OVR::Vector3f localFwd = invWorld.Transform(*viewPos + *viewFwd) - localPos;
+      float t0;
+      if (geom != NULL && geom->IntersectRay(localPos, localFwd, t0)) {
+        foundIntersection = true;
       }
     }
 
     // Next check if text boundaries have been intersected
-    if (ValueDefined(textVal)) {
-      OVR::String txtStr;
-      JS::RootedValue t(cx, *textVal);
-      if (!GetOVRStringVal(cx, t, &txtStr)) {
-        JS_ReportError(cx, "Could not get string data from text string");
-        return;
-      }
-
-      // Get metrics from the text (width/height is all we care about for now)
-      size_t txtLen;
-      float txtWidth;
-      float txtHeight;
-      float txtAscent;
-      float txtDescent;
-      float txtFontHeight;
-      int const TXT_MAX_LINES = 128;
-      float txtLineWidths[TXT_MAX_LINES];
-      int txtNumLines;
-      guiSys->GetDefaultFont().CalcTextMetrics(txtStr.ToCStr(), txtLen,
-        txtWidth, txtHeight, txtAscent, txtDescent, txtFontHeight,
-        txtLineWidths, TXT_MAX_LINES, txtNumLines);
-
+    float txtWidth, txtHeight;
+    if (ValueDefined(textVal) && GetTextMetrics(cx, guiSys, txtWidth, txtHeight)) {
       // Build quad vertices from the metrics + the model matrix
       OVR::Vector3f bl = worldMatrix.GetTranslation();
-      OVR::Vector3f br = worldMatrix.Transform(OVR::Vector3f(txtWidth * textSize, 0, 0));
-      OVR::Vector3f tl = worldMatrix.Transform(OVR::Vector3f(0, txtHeight * textSize, 0));
-      OVR::Vector3f tr = worldMatrix.Transform(OVR::Vector3f(txtWidth * textSize, txtHeight * textSize, 0));
+      OVR::Vector3f br = worldMatrix.Transform(OVR::Vector3f(txtWidth, 0, 0));
+      OVR::Vector3f tl = worldMatrix.Transform(OVR::Vector3f(0, txtHeight, 0));
+      OVR::Vector3f tr = worldMatrix.Transform(OVR::Vector3f(txtWidth, txtHeight, 0));
 
       float t0, u, v;
       // Triangle 1
@@ -317,30 +454,34 @@ void CoreModel::CallGazeCallbacks(JSContext* cx, OVR::OvrGuiSys* guiSys, OVR::Ve
       }
     }
   }
-
-  for (int i = 0; i < children.GetSizeI(); ++i) {
-    JS::RootedObject childObj(cx, &children[i].toObject());
-    CoreModel* child = GetCoreModel(childObj);
-    child->CallGazeCallbacks(cx, guiSys, viewPos, viewFwd, vrFrame, ev);
-  }
 }
 
-void CoreModel::DrawEyeView(JSContext* cx,
-                            OVR::OvrGuiSys* guiSys,
-                            const int eye,
-                            const OVR::Matrix4f& eyeViewMatrix,
-                            const OVR::Matrix4f& eyeProjectionMatrix,
-                            const OVR::Matrix4f& eyeViewProjection,
-                            ovrFrameParms& frameParms) {
+void CoreModel::RecordDraw(JSContext* cx, OVR::OvrGuiSys* guiSys, DrawList& list) {
   if (ValueDefined(geometryVal) && ValueDefined(programVal)) {
     // Extract the rendering primitives
-    OVR::GlProgram* prog = program(cx)->program;
-    OVR::GlGeometry* geom = geometry(cx)->geometry;
-
-    // Switch to our program
-    glUseProgram(prog->program);
-
-    // Bind textures
+    CoreProgram* coreProg = program(cx);
+    CoreGeometry* coreGeom = geometry(cx);
+    if (coreProg == NULL || coreGeom == NULL) {
+      JS_ReportError(cx, "Expected model %d to have a geometry and a program", id);
+      return;
+    }
+    coreGeom->Flush();
+    OVR::GlGeometry* geom = coreGeom->geometry;
+
+    DrawItem item;
+    item.program = coreProg->program;
+    item.instanceMatrixLocation = coreProg->instanceMatrixLocation;
+    item.vertexArrayObject = geom->vertexArrayObject;
+    item.indexCount = geom->indexCount;
+    item.indexType = coreGeom->indexType;
+    // Compact positions are quantized, so scale them back out as we draw
+    item.worldMatrix = coreGeom->compact ? worldMatrix * coreGeom->dequantize : worldMatrix;
+    item.textureStart = list.textures.GetSizeI();
+    item.textureCount = 0;
+    item.uniformStart = list.uniforms.GetSizeI();
+    item.uniformCount = 0;
+
+    // Resolve textures
     if (ValueDefined(texturesVal)) {
       JS::RootedValue textures(cx, *texturesVal);
 
@@ -364,108 +505,42 @@ void CoreModel::DrawEyeView(JSContext* cx,
         return;
       }
 
-      // Iterate through the textures and bind each one
+      // Iterate through the textures and record each one
       JS::RootedValue texture(cx);
       for (size_t i = 0; i < texturesLength; ++i) {
         if (!JS_GetElement(cx, texturesObj, i, &texture)) {
           JS_ReportError(cx, "Couldn't get texture at index %d", i);
+          list.textures.Resize(item.textureStart);
           return;
         }
         JS::RootedObject texObj(cx, &texture.toObject());
         CoreTexture* tex = GetCoreTexture(texObj);
         if (tex == NULL) {
           JS_ReportError(cx, "Texture was null at index %d", i);
+          list.textures.Resize(item.textureStart);
           return;
         }
-        glActiveTexture(GL_TEXTURE0 + i);
-        glBindTexture(tex->texture.target, tex->texture.texture);
+        DrawTexture drawTex;
+        drawTex.target = tex->texture.target;
+        drawTex.texture = tex->texture.texture;
+        list.textures.PushBack(drawTex);
       }
+      item.textureCount = list.textures.GetSizeI() - item.textureStart;
     }
 
-    // Now we bind our uniforms
-    glUniformMatrix4fv(prog->uModel, 1, GL_TRUE, worldMatrix.M[0]);
-    glUniformMatrix4fv(prog->uView, 1, GL_TRUE, eyeViewMatrix.M[0]);
-    glUniformMatrix4fv(prog->uProjection, 1, GL_TRUE, eyeProjectionMatrix.M[0]);
-
+    // Resolve uniforms
     JS::RootedObject uniforms(cx, &uniformsVal->toObject());
-    JS::Rooted<JS::IdVector> names(cx, JS::IdVector(cx));
-    if (!JS_Enumerate(cx, uniforms, &names)) {
-      JS_ReportError(cx, "Couldn't enumerate uniforms");
+    if (!coreProg->ResolveUniforms(cx, uniforms, list.uniforms)) {
+      list.textures.Resize(item.textureStart);
+      list.uniforms.Resize(item.uniformStart);
       return;
     }
-    JS::RootedValue nameVal(cx);
-    JS::RootedValue val(cx);
-    OVR::String name;
-    for (uint32_t i = 0; i < names.length(); ++i) {
-      // Root the ID
-      JS::RootedId nameId(cx, names[i]);
-
-      // Get the name string as a value
-      if (!JS_IdToValue(cx, nameId, &nameVal)) {
-        JS_ReportError(cx, "Could not convert the uniform id to a value");
-        return;
-      }
-
-      // Get the string out of the name value
-      if (!GetOVRStringVal(cx, nameVal, &name)) {
-        JS_ReportError(cx, "Could not convert the uniform name to a string");
-        return;
-      }
-
-      // Get the value from the id
-      if (!JS_GetPropertyById(cx, uniforms, nameId, &val)) {
-        JS_ReportError(cx, "Could not get the uniform value");
-        return;
-      }
-
-      // Get the location of the uniform
-      int loc = glGetUniformLocation(prog->program, name.ToCStr());
-
-      // Figure out what type the uniform is and then set it
-      if (val.isBoolean()) {
-        glUniform1i(loc, val.isTrue() ? 1 : 0);
-      } else if (val.isNumber()) {
-        glUniform1f(loc, val.toNumber());
-      } else if (val.isObject()) {
-        JS::RootedObject valObj(cx, &val.toObject());
-        if (JS_InstanceOf(cx, valObj, CoreVector2f_class(), NULL)) {
-          OVR::Vector2f* vec = GetVector2f(valObj);
-          glUniform2fv(loc, 1, &vec->x);
-        } else if (JS_InstanceOf(cx, valObj, CoreVector3f_class(), NULL)) {
-          OVR::Vector3f* vec = GetVector3f(valObj);
-          glUniform3fv(loc, 1, &vec->x);
-        } else if (JS_InstanceOf(cx, valObj, CoreVector4f_class(), NULL)) {
-          OVR::Vector4f* vec = GetVector4f(valObj);
-          glUniform4fv(loc, 1, &vec->x);
-        } else if (JS_InstanceOf(cx, valObj, CoreMatrix4f_class(), NULL)) {
-          OVR::Matrix4f* mat = GetMatrix4f(valObj);
-          glUniformMatrix4fv(loc, 1, GL_TRUE, mat->M[0]);
-        } else {
-          JS_ReportError(cx, "Uniform type unknown");
-          return;
-        }
-      } else {
-        JS_ReportError(cx, "Uniform type unknown");
-        return;
-      }
-    }
-
-    // Bind the vertex array
-    glBindVertexArray(geom->vertexArrayObject);
+    item.uniformCount = list.uniforms.GetSizeI() - item.uniformStart;
 
-    // Finally, draw the elements
-    glDrawElements(GL_TRIANGLES, geom->indexCount, GL_UNSIGNED_SHORT, NULL);
-
-    OVR::GL_CheckErrors("Model - DrawEyeView");
-
-    // Unbind
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, 0);
-    glBindVertexArray(0);
-    glUseProgram(0);
+    list.items.PushBack(item);
   }
 
-  // Render text if we have some
+  // Submit text once per frame; the font surface renders it into both eyes
   if (ValueDefined(textVal)) {
     OVR::String textStr;
     JS::RootedValue t(cx, *textVal);
@@ -477,7 +552,10 @@ void CoreModel::DrawEyeView(JSContext* cx,
     OVR::Vector4f textColor(0, 0, 0, 1);
     if (ValueDefined(textColorVal)) {
       JS::RootedObject textColorObj(cx, &textColorVal->toObject());
-      textColor = *(GetVector4f(textColorObj));
+      OVR::Vector4f* textColorVec = GetVector4f(textColorObj);
+      if (textColorVec != NULL) {
+        textColor = *textColorVec;
+      }
     }
 
     OVR::fontParms_t fontParms;
@@ -495,13 +573,6 @@ void CoreModel::DrawEyeView(JSContext* cx,
       textStr.ToCStr()
     );
   }
-
-  // Recurse
-  for (int i = 0; i < children.GetSizeI(); ++i) {
-    JS::RootedObject childObj(cx, &children[i].toObject());
-    CoreModel* child = GetCoreModel(childObj);
-    child->DrawEyeView(cx, guiSys, eye, eyeViewMatrix, eyeProjectionMatrix, eyeViewProjection, frameParms);
-  }
 }
 
 bool CoreModel::HasFrameCallback() {
@@ -534,42 +605,13 @@ btTransform CoreModel::GetTransform() {
 }
 
 void CoreModel::StartCollisions(JSContext* cx) {
-  if (ValueDefined(geometryVal) && ValueDefined(collideTagVal)) {
-    if (collisionShape != NULL) {
-      delete collisionShape;
-      collisionShape = NULL;
-    }
-    if (collisionObj != NULL) {
-      delete collisionObj;
-      collisionObj = NULL;
-    }
-    // TODO: Ensure there are none missing
-
-    CoreGeometry *geom = geometry(cx);
-
-    triMesh = new btTriangleMesh();
-    for (int i = 0; i < geom->indices.GetSizeI(); i += 3) {
-      OVR::Vector3f v0 = geom->vertices->position[geom->indices[i]];
-      OVR::Vector3f v1 = geom->vertices->position[geom->indices[i + 1]];
-      OVR::Vector3f v2 = geom->vertices->position[geom->indices[i + 2]];
-      triMesh->addTriangle(
-        btVector3(v0.x, v0.y, v0.z),
-        btVector3(v1.x, v1.y, v1.z),
-        btVector3(v2.x, v2.y, v2.z)
-      );
-    }
-    collisionShape = new btConvexTriangleMeshShape(triMesh, true);
-
-    btRigidBody::btRigidBodyConstructionInfo rbInfo(btScalar(1.0), NULL,
-      collisionShape, btVector3(0, 0, 0));
-    btRigidBody* body = new btRigidBody(rbInfo);
-
-    scene->dynamicsWorld->addRigidBody(body);
-
-    collisionObj = static_cast<btCollisionObject*>(body);
-    collisionObj->setUserIndex(id);
+  // Collision objects live in the scene's world, so wait until we're in one
+  if (scene == NULL) {
+    return;
   }
 
+  CreateCollisionObject(cx);
+
   for (int i = 0; i < children.GetSizeI(); ++i) {
     JS::RootedObject childObj(cx, &children[i].toObject());
     CoreModel* child = GetCoreModel(childObj);
@@ -577,22 +619,79 @@ void CoreModel::StartCollisions(JSContext* cx) {
   }
 }
 
-void CoreModel::StopCollisions() {
-  if (triMesh != NULL) {
-    delete triMesh;
-    triMesh = NULL;
+void CoreModel::CreateCollisionObject(JSContext* cx) {
+  if (scene == NULL || !ValueDefined(geometryVal) || !ValueDefined(collideTagVal)) {
+    return;
   }
+  StopCollisions();
+
+  // Every model using this geometry shares one hull; scale stays in the
+  // object's transform
+  CoreGeometry* geom = geometry(cx);
+  if (geom == NULL) {
+    return;
+  }
+  collisionShape = geom->AcquireCollisionShape(this);
+  collisionGeometry = geom;
+  collisionVersion = geom->boundsVersion;
+  JS::RootedValue geomVal(cx, *geometryVal);
+  collisionGeometryVal = new JS::Heap<JS::Value>(geomVal);
+
+  if (!CompileCollisionFilter(cx)) {
+    __android_log_print(ANDROID_LOG_WARN, LOG_COMPONENT, "Could not compile collision filter for model %d\n", id);
+  }
+
+  if (scene->dynamicsWorld != NULL) {
+    // Only dynamic models get mass; the others are moved by us alone
+    btScalar mass = collisionType == COLLISION_DYNAMIC ? btScalar(1.0) : btScalar(0.0);
+    btRigidBody::btRigidBodyConstructionInfo rbInfo(mass, NULL,
+      collisionShape, btVector3(0, 0, 0));
+    rbInfo.m_startWorldTransform = GetTransform();
+    collisionObj = new btRigidBody(rbInfo);
+    if (collisionType == COLLISION_KINEMATIC) {
+      collisionObj->setCollisionFlags(collisionObj->getCollisionFlags() | btCollisionObject::CF_KINEMATIC_OBJECT);
+    }
+  } else {
+    collisionObj = new btCollisionObject();
+    collisionObj->setCollisionShape(collisionShape);
+    collisionObj->setWorldTransform(GetTransform());
+    if (collisionType == COLLISION_STATIC) {
+      collisionObj->setCollisionFlags(btCollisionObject::CF_STATIC_OBJECT);
+    } else {
+      collisionObj->setCollisionFlags(btCollisionObject::CF_KINEMATIC_OBJECT);
+    }
+  }
+
+  // Inactive objects skip the per-frame AABB update, and pairs of them skip
+  // the narrowphase. Statics sleep for good, kinematics while they're still,
+  // and dynamics never.
+  if (collisionType == COLLISION_STATIC) {
+    collisionObj->forceActivationState(ISLAND_SLEEPING);
+  } else if (collisionType == COLLISION_DYNAMIC) {
+    collisionObj->forceActivationState(DISABLE_DEACTIVATION);
+  }
+  collisionTransformDirty = false;
+  AddCollisionObject();
+  collisionObj->setUserIndex(id);
+}
+
+void CoreModel::StopCollisions() {
   if (collisionObj != NULL) {
-    if (scene != NULL && scene->dynamicsWorld != NULL) {
-      scene->dynamicsWorld->removeCollisionObject(collisionObj);
+    if (scene != NULL && scene->collisionWorld != NULL) {
+      scene->WaitForCollisions();
+      scene->collisionWorld->removeCollisionObject(collisionObj);
     }
     delete collisionObj;
     collisionObj = NULL;
   }
-  if (collisionShape != NULL) {
-    delete collisionShape;
-    collisionShape = NULL;
+  // The shape is the geometry's, so just hand it back
+  if (collisionGeometry != NULL) {
+    collisionGeometry->ReleaseCollisionShape(this, collisionShape);
+    collisionGeometry = NULL;
   }
+  collisionShape = NULL;
+  delete collisionGeometryVal;
+  collisionGeometryVal = NULL;
   // TODO: Determine how to properly do this. We don't have access to cx.
   /*
   for (int i = 0; i < children.GetSizeI(); ++i) {
@@ -604,17 +703,132 @@ void CoreModel::StopCollisions() {
 }
 
 void CoreModel::UpdateCollisionObjects(JSContext* cx) {
-  if (collisionObj != NULL) {
-    collisionObj->setWorldTransform(GetTransform());
+  if (collisionObj == NULL) {
+    return;
   }
-  for (int i = 0; i < children.GetSizeI(); ++i) {
-    JS::RootedObject childObj(cx, &children[i].toObject());
-    CoreModel* child = GetCoreModel(childObj);
-    child->UpdateCollisionObjects(cx);
+  // Dynamic geometry whose positions moved has a new hull to wrap
+  if (collisionGeometry->boundsVersion != collisionVersion) {
+    CreateCollisionObject(cx);
+    return;
+  }
+  if (collisionType != COLLISION_DYNAMIC && !collisionTransformDirty) {
+    // Still kinematics go to sleep, so nothing about them gets redone. Bullet
+    // skips pairs where neither side is awake though, so one resting inside
+    // another static or kinematic object stays awake to keep reporting it.
+    if (collisionType == COLLISION_KINEMATIC) {
+      collisionObj->forceActivationState(collisionOverlapping ? ACTIVE_TAG : ISLAND_SLEEPING);
+    }
+    return;
+  }
+  collisionTransformDirty = false;
+  collisionObj->setWorldTransform(GetTransform());
+
+  if (collisionType == COLLISION_STATIC) {
+    // Sleeping objects are left out of the AABB update, so do ours now
+    scene->collisionWorld->updateSingleAabb(collisionObj);
+  } else if (collisionType == COLLISION_KINEMATIC) {
+    collisionObj->forceActivationState(ACTIVE_TAG);
+  }
+}
+
+// Tags get interned into filter bits the first time they're seen. The first
+// COLLISION_TAG_BITS each get their own, and the rest share the overflow bit.
+static const int COLLISION_TAG_BITS = 15;
+static const short COLLISION_TAG_OVERFLOW = (short)(1 << COLLISION_TAG_BITS);
+static OVR::Array<OVR::String> collisionTags;
+
+static short CollisionTagBit(const OVR::String& tag) {
+  for (int i = 0; i < collisionTags.GetSizeI(); ++i) {
+    if (collisionTags[i] == tag) {
+      return (short)(1 << i);
+    }
+  }
+  if (collisionTags.GetSizeI() < COLLISION_TAG_BITS) {
+    collisionTags.PushBack(tag);
+    return (short)(1 << (collisionTags.GetSizeI() - 1));
+  }
+  return COLLISION_TAG_OVERFLOW;
+}
+
+// Runs when collideTag or collidesWith is assigned, or when the model joins a
+// scene, never per frame. Edits made to the collidesWith object in place only
+// take effect once it's assigned again (model.collidesWith = model.collidesWith).
+// The object only re-enters the broadphase when its bits actually change.
+bool CoreModel::CompileCollisionFilter(JSContext* cx) {
+  short group = 0;
+  short mask = 0;
+
+  if (ValueDefined(collideTagVal)) {
+    OVR::String tag;
+    JS::RootedValue tagVal(cx, *collideTagVal);
+    if (!GetOVRStringVal(cx, tagVal, &tag)) {
+      return false;
+    }
+    group = CollisionTagBit(tag);
+  }
+
+  if (ValueDefined(collidesWithVal) && collidesWithVal->isObject()) {
+    JS::RootedObject collidesWith(cx, &collidesWithVal->toObject());
+    JS::Rooted<JS::IdVector> ids(cx, JS::IdVector(cx));
+    if (!JS_Enumerate(cx, collidesWith, &ids)) {
+      return false;
+    }
+    JS::RootedId tagId(cx);
+    JS::RootedValue tagVal(cx);
+    JS::RootedValue enabled(cx);
+    for (size_t i = 0; i < ids.length(); ++i) {
+      tagId = ids[i];
+      if (!JS_GetPropertyById(cx, collidesWith, tagId, &enabled)) {
+        return false;
+      }
+      if (!enabled.isTrue()) {
+        continue;
+      }
+      if (!JS_IdToValue(cx, tagId, &tagVal)) {
+        return false;
+      }
+      JS::RootedString tagStr(cx, JS::ToString(cx, tagVal));
+      OVR::String tag;
+      if (tagStr == NULL || !GetOVRString(cx, tagStr, &tag)) {
+        return false;
+      }
+      mask |= CollisionTagBit(tag);
+    }
+  }
+
+  if (group == collisionGroup && mask == collisionMask) {
+    return true;
+  }
+  collisionGroup = group;
+  collisionMask = mask;
+
+  // Filters are read when an object enters the broadphase, so re-enter it
+  if (collisionObj != NULL && scene != NULL) {
+    scene->WaitForCollisions();
+    scene->collisionWorld->removeCollisionObject(collisionObj);
+    AddCollisionObject();
+  }
+  return true;
+}
+
+void CoreModel::AddCollisionObject() {
+  // The world may be in use by the scene's collision thread
+  scene->WaitForCollisions();
+  btRigidBody* body = btRigidBody::upcast(collisionObj);
+  if (scene->dynamicsWorld != NULL && body != NULL) {
+    scene->dynamicsWorld->addRigidBody(body, collisionGroup, collisionMask);
+  } else {
+    scene->collisionWorld->addCollisionObject(collisionObj, collisionGroup, collisionMask);
   }
 }
 
 bool CoreModel::CheckCollision(JSContext* cx, CoreModel* otherModel) {
+  // The broadphase only lets through pairs whose bits match, so only tags
+  // sharing the overflow bit still need checking against the JS values
+  if (collisionGroup != COLLISION_TAG_OVERFLOW) {
+    return (collisionGroup & otherModel->collisionMask) != 0;
+  }
+
   if (!ValueDefined(collideTagVal) || !ValueDefined(otherModel->collidesWithVal)) {
     return false;
   }
@@ -634,80 +848,20 @@ bool CoreModel::CheckCollision(JSContext* cx, CoreModel* otherModel) {
   return rval.isTrue();
 }
 
-void CoreModel::CollidedWith(JSContext* cx, CoreModel* otherModel, JS::HandleValue ev) {
-  if (!CheckCollision(cx, otherModel) || !otherModel->CheckCollision(cx, this)) {
+void CoreModel::CallCollideCallback(JSContext* cx, JS::Heap<JS::Value>* callbackVal, const char* name, CoreModel* otherModel, JS::HandleValue ev) {
+  if (!ValueDefined(callbackVal)) {
     return;
   }
-
-  // Mark this id as seen
-  seenCollidingIds.PushBack(otherModel->id);
-
-  // First check to see if we're already colliding with 
-  for (int i = 0; i < collidingWithIds.GetSizeI(); ++i) {
-    if (collidingWithIds[i] == otherModel->id) {
-      return;
-    }
-  }
-
-  // If we made it here, it's a new collision, so trigger a callback
-  if (ValueDefined(onCollideStartVal)) {
-    JS::RootedValue callback(cx, *onCollideStartVal);
-    JS::RootedValue rval(cx);
-    JS::RootedValue evVal(cx, ev);
-    JS::RootedObject selfObj(cx, &selfVal->toObject());
-    if (!JS_CallFunctionValue(cx, selfObj, callback, JS::HandleValueArray(evVal), &rval)) {
-      JS_ReportError(cx, "Could not call onCollideStart callback");
-    }
-  }
-
-  // Now add this model's id to the colliding ids
-  collidingWithIds.PushBack(otherModel->id);
-}
-
-void CoreModel::FinishCollisions(JSContext* cx, JS::HandleValue ev) {
-  for (int i = 0; i < collidingWithIds.GetSizeI(); ++i) {
-    bool found = false;
-    for (int j = 0; j < seenCollidingIds.GetSizeI(); ++j) {
-      if (collidingWithIds[i] == seenCollidingIds[j]) {
-        found = true;
-        break;
-      }
-    }
-    if (!found) {
-      if (ValueDefined(onCollideEndVal)) {
-        JS::RootedValue callback(cx, *onCollideEndVal);
-        //CoreModel* otherModel = scene->ModelById(cx, collidingWithIds[i]);
-        JS::RootedValue rval(cx);
-        JS::RootedValue evVal(cx, ev);
-        JS::RootedObject selfObj(cx, &selfVal->toObject());
-        if (!JS_CallFunctionValue(cx, selfObj, callback, JS::HandleValueArray(evVal), &rval)) {
-          JS_ReportError(cx, "Could not call onCollideEnd callback");
-        }
-        break;
-      }
-    }
-  }
-
-  collidingWithIds = seenCollidingIds;
-  seenCollidingIds.Clear();
-}
-
-CoreModel* CoreModel::ModelById(JSContext* cx, int otherId) {
-  if (id == otherId) {
-    // FIXME: This is pretty gross, we're going the long way to get our own pointer
-    JS::RootedObject selfObj(cx, &selfVal->toObject());
-    CoreModel* model = GetCoreModel(selfObj);
-    return model;
-  }
-  for (int i = 0; i < children.GetSizeI(); ++i) {
-    JS::RootedObject childObj(cx, &children[i].toObject());
-    CoreModel* child = GetCoreModel(childObj);
-    CoreModel* model = child->ModelById(cx, otherId);
-    if (model != NULL) {
-      return model;
-    }
+  JS::RootedValue callback(cx, *callbackVal);
+  JS::RootedValue rval(cx);
+  JS::RootedObject selfObj(cx, &selfVal->toObject());
+  // The other model is null when it has already left the scene
+  JS::AutoValueArray<2> args(cx);
+  args[0].set(ev);
+  args[1].set(otherModel == NULL ? JS::NullValue() : *otherModel->selfVal);
+  if (!JS_CallFunctionValue(cx, selfObj, callback, args, &rval)) {
+    JS_ReportError(cx, "Could not call %s callback", name);
   }
-  return NULL;
 }
 
 bool CoreModel::LoadFile(JSContext* cx) {
@@ -740,10 +894,20 @@ bool CoreModel::LoadFile(JSContext* cx) {
     }
   }
   
-  // Load the model file in the memory buffer via Assimp
+  // Load the model file in the memory buffer via Assimp. Meshes too big for
+  // 16-bit indices get 32-bit ones, unless we've been asked to have Assimp
+  // split them up instead, for GPUs that are slow with 32-bit indices.
   Assimp::Importer importer;
-  const aiScene* scn = importer.ReadFileFromMemory(buf.Buffer, buf.Length,
-    /*aiProcessPreset_TargetRealtime_MaxQuality*/aiProcessPreset_TargetRealtime_Quality);
+  unsigned int steps = /*aiProcessPreset_TargetRealtime_MaxQuality*/aiProcessPreset_TargetRealtime_Quality;
+  if (splitLargeMeshes) {
+    importer.SetPropertyInteger(AI_CONFIG_PP_SLM_VERTEX_LIMIT, SHORT_INDEX_VERTEX_LIMIT - 1);
+    steps |= aiProcess_SplitLargeMeshes;
+  }
+  const aiScene* scn = importer.ReadFileFromMemory(buf.Buffer, buf.Length, steps);
+  if (scn == NULL) {
+    JS_ReportError(cx, "Could not import model file %s: %s", fileStr.ToCStr(), importer.GetErrorString());
+    return false;
+  }
 
   // Build a map of all textures
   OVR::Hash<OVR::String, OVR::GlTexture> textureMap;
@@ -814,7 +978,9 @@ bool CoreModel::LoadFile(JSContext* cx) {
       vertices->tangent.Resize(mesh->mNumVertices);
       vertices->binormal.Resize(mesh->mNumVertices);
     }
-    vertices->color.Resize(mesh->mNumVertices);
+    if (mesh->GetNumColorChannels() > 0) {
+      vertices->color.Resize(mesh->mNumVertices);
+    }
     if (mesh->GetNumUVChannels() > 0) {
       vertices->uv0.Resize(mesh->mNumVertices);
     }
@@ -841,8 +1007,8 @@ bool CoreModel::LoadFile(JSContext* cx) {
       }
       
       if (mesh->GetNumColorChannels() > 0) {
-        aiColor4D* color = mesh->mColors[vertexNum];
-        vertices->color[vertexNum] = OVR::Vector4f(color[0].r, color[0].g, color[0].b, color[0].a);
+        aiColor4D color = mesh->mColors[0][vertexNum];
+        vertices->color[vertexNum] = OVR::Vector4f(color.r, color.g, color.b, color.a);
       }
       if (mesh->GetNumColorChannels() > 1) {
         __android_log_print(ANDROID_LOG_WARN, LOG_COMPONENT, "Discarding extra color channels\n");
@@ -863,7 +1029,7 @@ bool CoreModel::LoadFile(JSContext* cx) {
     }
 
     // Build up our geometry indices
-    OVR::Array<OVR::TriangleIndex> indices;
+    OVR::Array<uint32_t> indices;
     indices.Resize(mesh->mNumFaces * 3);
     int indexIdx = 0; // lol
     for (unsigned int faceNum = 0; faceNum < mesh->mNumFaces; ++faceNum) {
@@ -909,7 +1075,7 @@ bool CoreModel::LoadFile(JSContext* cx) {
     
     // Add the model's geometry
     JS::RootedValue geometry(cx, JS::ObjectOrNullValue(
-      NewCoreGeometry(cx, new CoreGeometry(vertices, indices))));
+      NewCoreGeometry(cx, new CoreGeometry(vertices, indices, compactVertices))));
     model->geometryVal = new JS::Heap<JS::Value>(geometry);
 
     // Add the model's textures
@@ -936,25 +1102,25 @@ bool CoreModel::LoadFile(JSContext* cx) {
 void CoreModel::FillDefaults(JSContext* cx) {
   if (matrixVal == NULL) {
     JS::RootedValue matrix(cx, JS::ObjectOrNullValue(
-      NewCoreMatrix4f(cx, new OVR::Matrix4f())));
+      NewCoreMatrix4f(cx, OVR::Matrix4f())));
     matrixVal = new JS::Heap<JS::Value>(matrix);
   }
 
   if (positionVal == NULL) {
     JS::RootedValue position(cx, JS::ObjectOrNullValue(
-      NewCoreVector3f(cx, new OVR::Vector3f())));
+      NewCoreVector3f(cx, OVR::Vector3f())));
     positionVal = new JS::Heap<JS::Value>(position);
   }
   
   if (rotationVal == NULL) {
     JS::RootedValue rotation(cx, JS::ObjectOrNullValue(
-      NewCoreVector3f(cx, new OVR::Vector3f())));
+      NewCoreVector3f(cx, OVR::Vector3f())));
     rotationVal = new JS::Heap<JS::Value>(rotation);
   }
 
   if (scaleVal == NULL) {
     JS::RootedValue scale(cx, JS::ObjectOrNullValue(
-      NewCoreVector3f(cx, new OVR::Vector3f(1, 1, 1))));
+      NewCoreVector3f(cx, OVR::Vector3f(1, 1, 1))));
     scaleVal = new JS::Heap<JS::Value>(scale);
   }
 
@@ -973,16 +1139,15 @@ void CoreModel::FillDefaults(JSContext* cx) {
 
 VRJS_GETSET(CoreModel, geometry)
 VRJS_GETSET(CoreModel, program)
-VRJS_GETSET(CoreModel, matrix)
-VRJS_GETSET(CoreModel, position)
-VRJS_GETSET(CoreModel, rotation)
-VRJS_GETSET(CoreModel, scale)
+VRJS_GETSET_POST(CoreModel, matrix, item->MarkTransformDirty())
+VRJS_GETSET_POST(CoreModel, position, item->MarkTransformDirty())
+VRJS_GETSET_POST(CoreModel, rotation, item->MarkTransformDirty())
+VRJS_GETSET_POST(CoreModel, scale, item->MarkTransformDirty())
 VRJS_GETSET(CoreModel, textures)
 VRJS_GETSET_POST(CoreModel, file, item->LoadFile(cx))
-VRJS_GETSET(CoreModel, text)
+VRJS_GETSET_POST(CoreModel, text, item->InvalidateText())
 VRJS_GETSET(CoreModel, textColor)
-VRJS_GETSET(CoreModel, collideTag)
-VRJS_GETSET(CoreModel, collidesWith)
+VRJS_GETSET_POST(CoreModel, collidesWith, item->CompileCollisionFilter(cx))
 VRJS_GETSET(CoreModel, uniforms)
 VRJS_GETSET(CoreModel, onFrame)
 VRJS_GETSET(CoreModel, onGazeHoverOver)
@@ -993,10 +1158,88 @@ VRJS_GETSET(CoreModel, onGestureTouchCancel)
 VRJS_GETSET(CoreModel, onCollideStart)
 VRJS_GETSET(CoreModel, onCollideEnd)
 
+static bool CoreModel_get_collideTag(JSContext* cx, unsigned argc, JS::Value *vp) {
+  JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
+  JS::RootedObject self(cx, &args.thisv().toObject());
+  CoreModel* item = GetCoreModel(self);
+  args.rval().set(item == NULL || item->collideTagVal == NULL ? JS::NullValue() : *(item->collideTagVal));
+  return true;
+}
+
+static bool CoreModel_set_collideTag(JSContext* cx, unsigned argc, JS::Value* vp) {
+  JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
+  if (!args[0].isString()) {
+    JS_ReportError(cx, "Unexpected argument (expected collideTag string)");
+    return false;
+  }
+  JS::RootedObject self(cx, &args.thisv().toObject());
+  CoreModel* item = GetCoreModel(self);
+  if (item == NULL) {
+    return ReportWrongThis(cx, "Model");
+  }
+  JS::RootedValue newVal(cx, args[0]);
+  auto* oldVal = item->collideTagVal;
+  item->collideTagVal = new JS::Heap<JS::Value>(newVal);
+  delete oldVal;
+  return item->CompileCollisionFilter(cx);
+}
+
+static const char* collisionTypeNames[] = { "static", "kinematic", "dynamic" };
+
+static bool GetCollisionType(JSContext* cx, JS::HandleValue val, CollisionType* out) {
+  OVR::String name;
+  if (!GetOVRStringVal(cx, val, &name)) {
+    return false;
+  }
+  for (int i = 0; i < 3; ++i) {
+    if (name == collisionTypeNames[i]) {
+      *out = (CollisionType)i;
+      return true;
+    }
+  }
+  JS_ReportError(cx, "Unknown collisionType: %s", name.ToCStr());
+  return false;
+}
+
+static bool CoreModel_get_collisionType(JSContext* cx, unsigned argc, JS::Value *vp) {
+  JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
+  JS::RootedObject self(cx, &args.thisv().toObject());
+  CoreModel* item = GetCoreModel(self);
+  if (item == NULL) {
+    return ReportWrongThis(cx, "Model");
+  }
+  args.rval().setString(JS_NewStringCopyZ(cx, collisionTypeNames[item->collisionType]));
+  return true;
+}
+
+static bool CoreModel_set_collisionType(JSContext* cx, unsigned argc, JS::Value* vp) {
+  JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
+  JS::RootedObject self(cx, &args.thisv().toObject());
+  CoreModel* item = GetCoreModel(self);
+  if (item == NULL) {
+    return ReportWrongThis(cx, "Model");
+  }
+  CollisionType type;
+  if (!GetCollisionType(cx, args[0], &type)) {
+    return false;
+  }
+  if (type != item->collisionType) {
+    item->collisionType = type;
+    // The object's flags and mass depend on the type, so make a new one
+    if (item->collisionObj != NULL) {
+      item->CreateCollisionObject(cx);
+    }
+  }
+  return true;
+}
+
 static bool CoreModel_get_textSize(JSContext* cx, unsigned argc, JS::Value *vp) {
   JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
   JS::RootedObject self(cx, &args.thisv().toObject());
   CoreModel* item = GetCoreModel(self);
+  if (item == NULL) {
+    return ReportWrongThis(cx, "Model");
+  }
   args.rval().setNumber(item->textSize);
   return true;
 }
@@ -1009,7 +1252,11 @@ static bool CoreModel_set_textSize(JSContext* cx, unsigned argc, JS::Value* vp)
   }
   JS::RootedObject self(cx, &args.thisv().toObject());
   CoreModel* item = GetCoreModel(self);
+  if (item == NULL) {
+    return ReportWrongThis(cx, "Model");
+  }
   item->textSize = args[0].toNumber();
+  item->gazeBoundsDirty = true;
   return true;
 }
 
@@ -1017,6 +1264,9 @@ static bool CoreModel_get_textOutlineSize(JSContext* cx, unsigned argc, JS::Valu
   JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
   JS::RootedObject self(cx, &args.thisv().toObject());
   CoreModel* item = GetCoreModel(self);
+  if (item == NULL) {
+    return ReportWrongThis(cx, "Model");
+  }
   args.rval().setNumber(item->textOutlineSize);
   return true;
 }
@@ -1029,6 +1279,9 @@ static bool CoreModel_set_textOutlineSize(JSContext* cx, unsigned argc, JS::Valu
   }
   JS::RootedObject self(cx, &args.thisv().toObject());
   CoreModel* item = GetCoreModel(self);
+  if (item == NULL) {
+    return ReportWrongThis(cx, "Model");
+  }
   item->textOutlineSize = args[0].toNumber();
   return true;
 }
@@ -1048,6 +1301,7 @@ static JSPropertySpec CoreModel_props[] = {
   VRJS_PROP(CoreModel, textOutlineSize),
   VRJS_PROP(CoreModel, collideTag),
   VRJS_PROP(CoreModel, collidesWith),
+  VRJS_PROP(CoreModel, collisionType),
   VRJS_PROP(CoreModel, uniforms),
   VRJS_PROP(CoreModel, onFrame),
   VRJS_PROP(CoreModel, onGazeHoverOver),
@@ -1169,6 +1423,26 @@ bool CoreModel_constructor(JSContext* cx, unsigned argc, JS::Value *vp) {
     model->collidesWithVal = new JS::Heap<JS::Value>(collidesWith);
   }
 
+  // SplitLargeMeshes, which has to be known before the file loads
+  JS::RootedValue splitLargeMeshes(cx);
+  if (JS_GetProperty(cx, opts, "splitLargeMeshes", &splitLargeMeshes) && !splitLargeMeshes.isNullOrUndefined()) {
+    model->splitLargeMeshes = JS::ToBoolean(splitLargeMeshes);
+  }
+
+  // CompactVertices, likewise
+  JS::RootedValue compactVertices(cx);
+  if (JS_GetProperty(cx, opts, "compactVertices", &compactVertices) && !compactVertices.isNullOrUndefined()) {
+    model->compactVertices = JS::ToBoolean(compactVertices);
+  }
+
+  // CollisionType
+  JS::RootedValue collisionType(cx);
+  if (JS_GetProperty(cx, opts, "collisionType", &collisionType) && !collisionType.isNullOrUndefined()) {
+    if (!GetCollisionType(cx, collisionType, &model->collisionType)) {
+      return false;
+    }
+  }
+
   // Uniforms
   JS::RootedValue uniforms(cx);
   if (JS_GetProperty(cx, opts, "uniforms", &uniforms) && !uniforms.isNullOrUndefined() && uniforms.isObject()) {
@@ -1223,6 +1497,7 @@ void CoreModel_trace(JSTracer* tracer, JSObject* obj) {
     TraceHeap(tracer, model->textColorVal, "model", "textColorVal");
     TraceHeap(tracer, model->collideTagVal, "model", "collideTagVal");
     TraceHeap(tracer, model->collidesWithVal, "model", "collidesWithVal");
+    TraceHeap(tracer, model->collisionGeometryVal, "model", "collisionGeometryVal");
     TraceHeap(tracer, model->uniformsVal, "model", "uniformsVal");
     TraceHeap(tracer, model->onFrameVal, "model", "onFrameVal");
     TraceHeap(tracer, model->onGazeHoverOverVal, "model", "onGazeHoverOverVal");
@@ -1255,10 +1530,17 @@ bool CoreModel_add(JSContext* cx, unsigned argc, JS::Value *vp) {
   }
 
   JS::RootedObject otherModelObj(cx, &args[0].toObject());
+  if (GetCoreModel(otherModelObj) == NULL) {
+    JS_ReportError(cx, "Expected add to take a model argument");
+    return false;
+  }
 
   // Read the model object in
   JS::RootedObject thisObj(cx, &args.thisv().toObject());
   CoreModel* thisModel = GetCoreModel(thisObj);
+  if (thisModel == NULL) {
+    return ReportWrongThis(cx, "Model");
+  }
 
   thisModel->AddModel(cx, otherModelObj);
 
@@ -1280,17 +1562,26 @@ bool CoreModel_remove(JSContext* cx, unsigned argc, JS::Value *vp) {
 
   JS::RootedObject otherModelObj(cx, &args[0].toObject());
   CoreModel* otherModel = GetCoreModel(otherModelObj);
+  if (otherModel == NULL) {
+    JS_ReportError(cx, "Expected remove to take a model argument");
+    return false;
+  }
 
   JS::RootedObject thisObj(cx, &args.thisv().toObject());
   CoreModel* thisModel = GetCoreModel(thisObj);
+  if (thisModel == NULL) {
+    return ReportWrongThis(cx, "Model");
+  }
 
-  // Make sure collision detection is stopped
-  otherModel->StopCollisions();
-
-  // Remove the scene object from the model
-  otherModel->scene = NULL;
+  // Anything below us can be removed, not just our direct children
+  CoreModel* ancestor = otherModel->parent;
+  while (ancestor != NULL && ancestor != thisModel) {
+    ancestor = ancestor->parent;
+  }
 
-  if (!thisModel->RemoveModel(cx, otherModel)) {
+  // Unlinking takes the whole subtree out of the scene too, stopping its
+  // collision detection
+  if (ancestor == NULL || !otherModel->Unlink(cx)) {
     JS_ReportError(cx, "Could not find model to remove");
     return false;
   }
@@ -1298,42 +1589,44 @@ bool CoreModel_remove(JSContext* cx, unsigned argc, JS::Value *vp) {
   return true;
 }
 
+static JS::PersistentRootedObject coreModelProto;
+
+static JSFunctionSpec CoreModel_methods[] = {
+  JS_FN("add", CoreModel_add, 0, 0),
+  JS_FN("remove", CoreModel_remove, 0, 0),
+  JS_FS_END
+};
+
 void SetupCoreModel(JSContext* cx, JS::RootedObject *global, JS::RootedObject *core) {
   JSObject *obj = JS_InitClass(
       cx,
       *core,
-      *global,
+      nullptr,
       &coreModelClass,
       CoreModel_constructor,
       1,
-      nullptr, /* Properties */
-      nullptr, /* Methods */
+      CoreModel_props, /* Properties */
+      CoreModel_methods, /* Methods */
       nullptr, /* Static Props */
       nullptr  /* Static Methods */);
   if (!obj) {
     __android_log_print(ANDROID_LOG_ERROR, LOG_COMPONENT, "Could not construct env.core.Model class\n");
     return;
   }
+  coreModelProto.init(cx, obj);
 }
 
 JSObject* NewCoreModel(JSContext* cx, CoreModel* model) {
-  JS::RootedObject self(cx, JS_NewObject(cx, &coreModelClass));
-  if (!JS_DefineProperties(cx, self, CoreModel_props)) {
-    __android_log_print(ANDROID_LOG_ERROR, LOG_COMPONENT, "Could not define properties on model\n");
-  }
-  if (!JS_DefineFunction(cx, self, "add", &CoreModel_add, 0, 0)) {
-    JS_ReportError(cx, "Could not create model.add function");
-    return NULL;
-  }
-  if (!JS_DefineFunction(cx, self, "remove", &CoreModel_remove, 0, 0)) {
-    JS_ReportError(cx, "Could not create model.remove function");
-    return NULL;
-  }
+  JS::RootedObject self(cx, JS_NewObjectWithGivenProto(cx, &coreModelClass, coreModelProto));
   JS_SetPrivate(self, (void *)model);
   return self;
 }
 
 CoreModel* GetCoreModel(JS::HandleObject obj) {
+  // The prototype and objects of other classes have no payload for us
+  if (JS_GetClass(obj) != &coreModelClass) {
+    return NULL;
+  }
   CoreModel* model = (CoreModel*)JS_GetPrivate(obj);
   return model;
 }
\ No newline at end of file
@@ -7,23 +7,48 @@
 #include "CoreVector3f.h"
 #include "CoreMatrix4f.h"
 #include "CoreTexture.h"
+#include "TransformKernel.h"
+#include "DrawList.h"
 
 class CoreScene;
 
+// How a model's collision object is kept up to date. Static ones never
+// expect to move, kinematic ones are placed whenever their transform
+// changes, and dynamic ones are placed every frame.
+enum CollisionType {
+  COLLISION_STATIC,
+  COLLISION_KINEMATIC,
+  COLLISION_DYNAMIC
+};
+
 class CoreModel {
 public:
   int id;
+  int graphIndex; // Position in the scene's flattened graph, or -1
+
+  // Where we hang in the tree. Scene roots have no parent model, and their
+  // childIndex is into the scene's children.
+  CoreModel* parent;
+  int childIndex;
 
   // State
   bool isHovered;
   bool isTouching;
-  OVR::Array<int> collidingWithIds;
-  OVR::Array<int> seenCollidingIds;
 
-  // Collision State
-  btTriangleMesh* triMesh;
+  // Collision State. The shape belongs to the geometry, which we keep alive
+  // through collisionGeometryVal for as long as the collision object uses it.
   btCollisionShape* collisionShape;
   btCollisionObject* collisionObj;
+  JS::Heap<JS::Value>* collisionGeometryVal;
+  CoreGeometry* collisionGeometry;
+  int collisionVersion; // collisionGeometry's boundsVersion when we took its shape
+  // collideTag and collidesWith compiled into broadphase filter bits when they
+  // are assigned; in-place edits to collidesWith need a reassignment
+  short collisionGroup;
+  short collisionMask;
+  CollisionType collisionType;
+  bool collisionTransformDirty; // The world matrix moved since we last placed the object
+  bool collisionOverlapping; // The broadphase had us overlapping something last pass
 
   // Parent
   CoreScene* scene;
@@ -56,6 +81,11 @@ public:
   float textSize;
   float textOutlineSize;
 
+  // Have Assimp break file meshes up so each fits 16-bit indices
+  bool splitLargeMeshes;
+  // Load file meshes as compact, quantized geometry (see CompactVertices.h)
+  bool compactVertices;
+
   // Collision properties
   JS::Heap<JS::Value>* collideTagVal;
   JS::Heap<JS::Value>* collidesWithVal;
@@ -83,25 +113,60 @@ public:
   OVR::Matrix4f localMatrix;
   OVR::Matrix4f worldMatrix;
 
+  // World space bounds, refreshed when the transform or geometry changes. A
+  // negative radius means there's nothing to draw, and FLT_MAX means the model
+  // can't be culled (text has no bounds we know of).
+  OVR::Bounds3f geometryBounds;
+  OVR::Vector3f worldCenter;
+  float worldRadius;
+  CoreGeometry* boundsGeometry;
+  int boundsVersion; // boundsGeometry's boundsVersion when we last looked
+  bool boundsHaveText;
+
+  // Gaze broadphase entry, covering both the geometry and any text
+  btDbvtNode* gazeLeaf;
+  OVR::Bounds3f gazeBounds;
+  bool gazeBoundsDirty;
+
+  // Cached text metrics, unscaled by textSize
+  bool textMetricsValid;
+  float textWidth;
+  float textHeight;
+
+  // Transform change tracking (last seen change stamps of the transform values)
+  bool transformDirty;
+  int32_t matrixStamp;
+  int32_t positionStamp;
+  int32_t rotationStamp;
+  int32_t scaleStamp;
+
   CoreModel();
   ~CoreModel();
   void AddModel(JSContext* cx, JS::HandleObject otherModelObj);
-  bool RemoveModel(JSContext* cx, CoreModel* model);
-  void ComputeMatrices(JSContext* cx, OVR::Matrix4f& transform);
+  bool Unlink(JSContext* cx);
+  bool MarkTransformDirty();
+  bool TransformChanged();
+  void GatherTransform(JSContext* cx, TransformSoA& trs, int idx);
+  void UpdateWorldBounds(JSContext* cx, bool worldChanged);
+  OVR::Bounds3f TransformBounds(const OVR::Bounds3f& local);
+  bool InvalidateText();
+  bool GetTextMetrics(JSContext* cx, OVR::OvrGuiSys* guiSys, float& width, float& height);
+  bool UpdateGazeBounds(JSContext* cx, OVR::OvrGuiSys* guiSys);
   void CallFrameCallbacks(JSContext* cx, JS::HandleValue ev);
   void CallGazeCallbacks(JSContext* cx, OVR::OvrGuiSys* guiSys, OVR::Vector3f* viewPos, OVR::Vector3f* viewFwd, const OVR::VrFrame& vrFrame, JS::HandleValue ev);
-  void DrawEyeView(JSContext* cx, OVR::OvrGuiSys* guiSys, const int eye, const OVR::Matrix4f& eyeViewMatrix, const OVR::Matrix4f& eyeProjectionMatrix, const OVR::Matrix4f& eyeViewProjection, ovrFrameParms& frameParms);
+  void RecordDraw(JSContext* cx, OVR::OvrGuiSys* guiSys, DrawList& list);
   bool HasFrameCallback();
   bool HasGazeCallback();
   bool HasGestureCallback();
   btTransform GetTransform();
   void StartCollisions(JSContext* cx);
+  void CreateCollisionObject(JSContext* cx);
   void StopCollisions();
+  bool CompileCollisionFilter(JSContext* cx);
+  void AddCollisionObject();
   void UpdateCollisionObjects(JSContext* cx);
   bool CheckCollision(JSContext* cx, CoreModel* otherModel);
-  void CollidedWith(JSContext* cx, CoreModel* otherModel, JS::HandleValue ev);
-  void FinishCollisions(JSContext* cx, JS::HandleValue ev);
-  CoreModel* ModelById(JSContext* cx, int otherId);
+  void CallCollideCallback(JSContext* cx, JS::Heap<JS::Value>* callbackVal, const char* name, CoreModel* otherModel, JS::HandleValue ev);
   bool LoadFile(JSContext* cx);
   void FillDefaults(JSContext* cx);
 };
@@ -112,5 +177,6 @@ CoreModel* GetCoreModel(JS::HandleObject obj);
 void CoreModel_finalize(JSFreeOp *fop, JSObject *obj);
 void CoreModel_trace(JSTracer *tracer, JSObject *obj);
 bool CallbackDefined(JS::Heap<JS::Value>* val);
+bool SwapRemoveChild(JSContext* cx, OVR::Array<JS::Heap<JS::Value>>& siblings, CoreModel* model);
 
 #endif
\ No newline at end of file
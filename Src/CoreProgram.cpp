@@ -1,8 +1,13 @@
 #include "CoreProgram.h"
+#include "CoreVector2f.h"
+#include "CoreVector3f.h"
+#include "CoreVector4f.h"
+#include "CoreMatrix4f.h"
 
 
 CoreProgram::CoreProgram(void) {
   program = NULL;
+  instanceMatrixLocation = -1;
 }
 
 CoreProgram::~CoreProgram(void) {
@@ -50,9 +55,268 @@ bool CoreProgram::Rebuild(JSContext* cx) {
   program = heapProgram;
   delete oldProgram;
 
+  // Programs opt into instanced drawing by reading their model matrix from a
+  // per-instance attribute instead of the Modelm uniform
+  instanceMatrixLocation = glGetAttribLocation(program->program, "ModelmInstanced");
+
+  return IntrospectUniforms(cx);
+}
+
+// Scripts set uniforms from numbers, booleans, the vector classes and
+// Matrix4f, which leaves no way to give a value for these
+static bool IsSettableUniformType(GLenum type) {
+  switch (type) {
+    case GL_FLOAT_MAT2:
+    case GL_FLOAT_MAT3:
+    case GL_FLOAT_MAT2x3:
+    case GL_FLOAT_MAT2x4:
+    case GL_FLOAT_MAT3x2:
+    case GL_FLOAT_MAT3x4:
+    case GL_FLOAT_MAT4x2:
+    case GL_FLOAT_MAT4x3:
+      return false;
+    default:
+      return true;
+  }
+}
+
+bool CoreProgram::IntrospectUniforms(JSContext* cx) {
+  uniforms.Clear();
+
+  GLint count = 0;
+  GLint maxLength = 0;
+  glGetProgramiv(program->program, GL_ACTIVE_UNIFORMS, &count);
+  glGetProgramiv(program->program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+  if (count <= 0) {
+    return true;
+  }
+
+  OVR::Array<char> nameBuf;
+  nameBuf.Resize(maxLength + 1);
+  for (GLint i = 0; i < count; ++i) {
+    GLsizei length = 0;
+    GLint size = 0;
+    GLenum type = 0;
+    glGetActiveUniform(program->program, i, maxLength + 1, &length, &size, &type, &nameBuf[0]);
+
+    // Arrays are reported as "name[0]", but scripts refer to them by name
+    if (length > 3 && strcmp(&nameBuf[length - 3], "[0]") == 0) {
+      length -= 3;
+      nameBuf[length] = '\0';
+    }
+    if (strncmp(&nameBuf[0], "gl_", 3) == 0) {
+      continue;
+    }
+
+    GLint location = glGetUniformLocation(program->program, &nameBuf[0]);
+    // Skip the matrices that the model binds itself
+    if (location == -1 ||
+        location == program->uModel ||
+        location == program->uView ||
+        location == program->uProjection ||
+        location == program->uMvp) {
+      continue;
+    }
+
+    JSString* atom = JS_AtomizeAndPinString(cx, &nameBuf[0]);
+    if (atom == NULL) {
+      JS_ReportError(cx, "Could not intern uniform name %s", &nameBuf[0]);
+      return false;
+    }
+
+    CoreUniform uniform;
+    uniform.id = INTERNED_STRING_TO_JSID(cx, atom);
+    uniform.location = location;
+    uniform.type = type;
+    uniform.settable = size == 1 && IsSettableUniformType(type);
+    uniform.name = &nameBuf[0];
+    uniforms.PushBack(uniform);
+  }
+
+  return true;
+}
+
+static bool UniformTypeError(JSContext* cx, const CoreUniform& uniform) {
+  JS_ReportError(cx, "Uniform %s was given a value of the wrong type", uniform.name.ToCStr());
+  return false;
+}
+
+// Reads a Vector2f/3f/4f with the given number of components, or returns NULL.
+// The class prototypes pass the class check but have no vector behind them.
+static const float* GetVectorUniform(JS::HandleObject valObj, const JSClass* clasp, int components) {
+  if (components == 2 && clasp == CoreVector2f_class()) {
+    OVR::Vector2f* vec = GetVector2f(valObj);
+    return vec == NULL ? NULL : &vec->x;
+  } else if (components == 3 && clasp == CoreVector3f_class()) {
+    OVR::Vector3f* vec = GetVector3f(valObj);
+    return vec == NULL ? NULL : &vec->x;
+  } else if (components == 4 && clasp == CoreVector4f_class()) {
+    OVR::Vector4f* vec = GetVector4f(valObj);
+    return vec == NULL ? NULL : &vec->x;
+  }
+  return NULL;
+}
+
+static int UniformComponents(GLenum type) {
+  switch (type) {
+    case GL_FLOAT_VEC2:
+    case GL_INT_VEC2:
+    case GL_BOOL_VEC2:
+    case GL_UNSIGNED_INT_VEC2:
+      return 2;
+    case GL_FLOAT_VEC3:
+    case GL_INT_VEC3:
+    case GL_BOOL_VEC3:
+    case GL_UNSIGNED_INT_VEC3:
+      return 3;
+    case GL_FLOAT_VEC4:
+    case GL_INT_VEC4:
+    case GL_BOOL_VEC4:
+    case GL_UNSIGNED_INT_VEC4:
+      return 4;
+    default:
+      return 1;
+  }
+}
+
+bool CoreProgram::ResolveUniforms(JSContext* cx, JS::HandleObject uniformsObj, OVR::Array<DrawUniform>& out) {
+  JS::RootedValue val(cx);
+  JS::RootedObject valObj(cx);
+  for (int i = 0; i < uniforms.GetSizeI(); ++i) {
+    const CoreUniform& uniform = uniforms[i];
+
+    JS::RootedId id(cx, uniform.id);
+    if (!JS_GetPropertyById(cx, uniformsObj, id, &val)) {
+      JS_ReportError(cx, "Could not get the uniform value");
+      return false;
+    }
+    if (val.isUndefined()) {
+      continue;
+    }
+    if (!uniform.settable) {
+      JS_ReportError(cx, "Uniform %s is an array or a matrix type other than mat4, which can't be set", uniform.name.ToCStr());
+      return false;
+    }
+
+    // The GL type tells us what to expect, so a class check is all we need
+    const JSClass* clasp = NULL;
+    if (val.isObject()) {
+      valObj = &val.toObject();
+      clasp = JS_GetClass(valObj);
+    }
+
+    DrawUniform resolved;
+    resolved.location = uniform.location;
+    resolved.type = uniform.type;
+    memset(resolved.intValues, 0, sizeof(resolved.intValues));
+    const float* vec = NULL;
+    switch (uniform.type) {
+      case GL_FLOAT:
+        if (val.isNumber()) {
+          resolved.floatValues[0] = val.toNumber();
+        } else if (val.isBoolean()) {
+          resolved.floatValues[0] = val.isTrue() ? 1.0f : 0.0f;
+        } else {
+          return UniformTypeError(cx, uniform);
+        }
+        break;
+      case GL_FLOAT_VEC2:
+      case GL_FLOAT_VEC3:
+      case GL_FLOAT_VEC4:
+        vec = GetVectorUniform(valObj, clasp, UniformComponents(uniform.type));
+        if (vec == NULL) {
+          return UniformTypeError(cx, uniform);
+        }
+        memcpy(resolved.floatValues, vec, sizeof(float) * UniformComponents(uniform.type));
+        break;
+      case GL_INT_VEC2:
+      case GL_INT_VEC3:
+      case GL_INT_VEC4:
+      case GL_BOOL_VEC2:
+      case GL_BOOL_VEC3:
+      case GL_BOOL_VEC4:
+      case GL_UNSIGNED_INT_VEC2:
+      case GL_UNSIGNED_INT_VEC3:
+      case GL_UNSIGNED_INT_VEC4:
+        // Integer vectors come from the float vector classes too
+        vec = GetVectorUniform(valObj, clasp, UniformComponents(uniform.type));
+        if (vec == NULL) {
+          return UniformTypeError(cx, uniform);
+        }
+        for (int c = 0; c < UniformComponents(uniform.type); ++c) {
+          resolved.intValues[c] = (GLint)vec[c];
+        }
+        break;
+      case GL_FLOAT_MAT4:
+        if (clasp != CoreMatrix4f_class() || GetMatrix4f(valObj) == NULL) {
+          return UniformTypeError(cx, uniform);
+        }
+        memcpy(resolved.floatValues, GetMatrix4f(valObj)->M[0], sizeof(float) * 16);
+        break;
+      default:
+        // Booleans, ints, unsigned ints and samplers
+        if (val.isBoolean()) {
+          resolved.intValues[0] = val.isTrue() ? 1 : 0;
+        } else if (val.isNumber()) {
+          resolved.intValues[0] = (GLint)val.toNumber();
+        } else {
+          return UniformTypeError(cx, uniform);
+        }
+        break;
+    }
+    out.PushBack(resolved);
+  }
   return true;
 }
 
+void ApplyDrawUniform(const DrawUniform& uniform) {
+  switch (uniform.type) {
+    case GL_FLOAT:
+      glUniform1f(uniform.location, uniform.floatValues[0]);
+      break;
+    case GL_FLOAT_VEC2:
+      glUniform2fv(uniform.location, 1, uniform.floatValues);
+      break;
+    case GL_FLOAT_VEC3:
+      glUniform3fv(uniform.location, 1, uniform.floatValues);
+      break;
+    case GL_FLOAT_VEC4:
+      glUniform4fv(uniform.location, 1, uniform.floatValues);
+      break;
+    case GL_FLOAT_MAT4:
+      glUniformMatrix4fv(uniform.location, 1, GL_TRUE, uniform.floatValues);
+      break;
+    case GL_INT_VEC2:
+    case GL_BOOL_VEC2:
+      glUniform2iv(uniform.location, 1, uniform.intValues);
+      break;
+    case GL_INT_VEC3:
+    case GL_BOOL_VEC3:
+      glUniform3iv(uniform.location, 1, uniform.intValues);
+      break;
+    case GL_INT_VEC4:
+    case GL_BOOL_VEC4:
+      glUniform4iv(uniform.location, 1, uniform.intValues);
+      break;
+    case GL_UNSIGNED_INT:
+      glUniform1ui(uniform.location, (GLuint)uniform.intValues[0]);
+      break;
+    case GL_UNSIGNED_INT_VEC2:
+      glUniform2uiv(uniform.location, 1, (const GLuint*)uniform.intValues);
+      break;
+    case GL_UNSIGNED_INT_VEC3:
+      glUniform3uiv(uniform.location, 1, (const GLuint*)uniform.intValues);
+      break;
+    case GL_UNSIGNED_INT_VEC4:
+      glUniform4uiv(uniform.location, 1, (const GLuint*)uniform.intValues);
+      break;
+    default:
+      // Ints, bools and samplers. Unsettable types never get this far.
+      glUniform1i(uniform.location, uniform.intValues[0]);
+      break;
+  }
+}
+
 static JSClass coreProgramClass = {
   "Program",              /* name */
   JSCLASS_HAS_PRIVATE,   /* flags */
@@ -125,15 +389,17 @@ void CoreProgram_trace(JSTracer *tracer, JSObject *obj) {
   __android_log_print(ANDROID_LOG_DEBUG, LOG_COMPONENT, "Finished tracing program\n");
 }
 
+static JS::PersistentRootedObject coreProgramProto;
+
 void SetupCoreProgram(JSContext* cx, JS::RootedObject *global, JS::RootedObject *core) {
   JSObject *obj = JS_InitClass(
       cx,
       *core,
-      *global,
+      nullptr,
       &coreProgramClass,
       CoreProgram_constructor,
       2,
-      nullptr, /* Properties */
+      CoreProgram_props, /* Properties */
       nullptr, /* Methods */
       nullptr, /* Static Props */
       nullptr  /* Static Methods */);
@@ -141,17 +407,19 @@ void SetupCoreProgram(JSContext* cx, JS::RootedObject *global, JS::RootedObject
     __android_log_print(ANDROID_LOG_ERROR, LOG_COMPONENT, "Could not construct env.core.Program class\n");
     return;
   }
+  coreProgramProto.init(cx, obj);
 }
 
 JSObject* NewCoreProgram(JSContext* cx, CoreProgram* prog) {
-  JS::RootedObject self(cx, JS_NewObject(cx, &coreProgramClass));
-  if (!JS_DefineProperties(cx, self, CoreProgram_props)) {
-    __android_log_print(ANDROID_LOG_ERROR, LOG_COMPONENT, "Could not define properties on program\n");
-  }
+  JS::RootedObject self(cx, JS_NewObjectWithGivenProto(cx, &coreProgramClass, coreProgramProto));
   JS_SetPrivate(self, (void *)prog);
   return self;
 }
 
 CoreProgram* GetCoreProgram(JS::HandleObject obj) {
+  // The prototype and objects of other classes have no payload for us
+  if (JS_GetClass(obj) != &coreProgramClass) {
+    return NULL;
+  }
   return (CoreProgram*)JS_GetPrivate(obj);
 }
\ No newline at end of file
@@ -3,14 +3,38 @@
 
 #include "BaseInclude.h"
 
+// An active uniform of a linked program, keyed by its pinned property id so it
+// can be looked up on a model's uniforms object without any string handling
+struct CoreUniform {
+  jsid id;
+  GLint location;
+  GLenum type;
+  bool settable; // False for types scripts have no value for, like mat3 or arrays
+  OVR::String name;
+};
+
+// A uniform value read out of a model's uniforms object, ready to hand to GL
+struct DrawUniform {
+  GLint location;
+  GLenum type;
+  GLint intValues[4]; // Also holds bools and unsigned ints
+  float floatValues[16];
+};
+
+void ApplyDrawUniform(const DrawUniform& uniform);
+
 class CoreProgram {
 public:
   JS::Heap<JS::Value>* vertexVal;
   JS::Heap<JS::Value>* fragmentVal;
   OVR::GlProgram* program;
+  OVR::Array<CoreUniform> uniforms;
+  GLint instanceMatrixLocation; // ModelmInstanced attribute, or -1 if the program doesn't instance
   CoreProgram();
   ~CoreProgram();
   bool Rebuild(JSContext* cx);
+  bool IntrospectUniforms(JSContext* cx);
+  bool ResolveUniforms(JSContext* cx, JS::HandleObject uniformsObj, OVR::Array<DrawUniform>& out);
 };
 
 void SetupCoreProgram(JSContext* cx, JS::RootedObject *global, JS::RootedObject *core);
@@ -1,14 +1,20 @@
 #include "CoreScene.h"
+#include "bullet/BulletMultiThreaded/PosixThreadSupport.h"
+#include "bullet/BulletMultiThreaded/SpuGatheringCollisionDispatcher.h"
+#include "bullet/BulletMultiThreaded/SpuNarrowPhaseCollisionTask/SpuGatheringCollisionTask.h"
+
+// More narrowphase workers than this won't find cores to run on. Bullet's
+// PosixThreadSupport keeps its main semaphore in a file-level static, so only
+// one can exist at a time, which limits workers to one scene at a time.
+static const int MAX_COLLISION_THREADS = 16;
+static bool collisionThreadSupportTaken = false;
 
 
 CoreScene::CoreScene(void) {
   lastCollisionTick = 0;
-  collisionConfiguration = new btDefaultCollisionConfiguration();
-  dispatcher = new  btCollisionDispatcher(collisionConfiguration);
-  overlappingPairCache = new btDbvtBroadphase();
-  solver = new btSequentialImpulseConstraintSolver;
-  dynamicsWorld = new btDiscreteDynamicsWorld(dispatcher, overlappingPairCache,
-    solver, collisionConfiguration);
+  collisionThread = NULL;
+  freshFrameEvents = false;
+  CreateCollisionWorld(false, 0);
   backgroundVal = NULL;
   globe = OVR::BuildGlobe();
   cubeProgram = OVR::BuildProgram(
@@ -61,175 +67,503 @@ CoreScene::CoreScene(void) {
 CoreScene::~CoreScene(void) {
   delete clearColorVal;
   delete backgroundVal;
-  delete dynamicsWorld;
+  delete collisionThread;
+  DestroyCollisionWorld();
+}
+
+// With threads, the narrowphase for the frame's pairs is handed out to that
+// many workers, and the dispatch returns once they've all finished
+static btCollisionDispatcher* NewCollisionDispatcher(btCollisionConfiguration* config, int threads, btThreadSupportInterface** threadSupport) {
+  if (threads <= 0) {
+    *threadSupport = NULL;
+    return new btCollisionDispatcher(config);
+  }
+  PosixThreadSupport::ThreadConstructionInfo info("collision",
+    processCollisionTask, createCollisionLocalStoreMemory, threads);
+  *threadSupport = new PosixThreadSupport(info);
+  collisionThreadSupportTaken = true;
+  return new SpuGatheringCollisionDispatcher(*threadSupport, threads, config);
+}
+
+static void DeleteCollisionThreadSupport(btThreadSupportInterface* threadSupport) {
+  if (threadSupport != NULL) {
+    delete threadSupport;
+    collisionThreadSupportTaken = false;
+  }
+}
+
+void CoreScene::CreateCollisionWorld(bool dynamics, int threads) {
+  collisionThreads = threads;
+  collisionConfiguration = new btDefaultCollisionConfiguration();
+  dispatcher = NewCollisionDispatcher(collisionConfiguration, threads, &collisionThreadSupport);
+  overlappingPairCache = new btDbvtBroadphase();
+  if (dynamics) {
+    solver = new btSequentialImpulseConstraintSolver;
+    dynamicsWorld = new btDiscreteDynamicsWorld(dispatcher, overlappingPairCache,
+      solver, collisionConfiguration);
+    collisionWorld = dynamicsWorld;
+  } else {
+    // All we report is contacts, so skip the solver and integration entirely
+    solver = NULL;
+    dynamicsWorld = NULL;
+    collisionWorld = new btCollisionWorld(dispatcher, overlappingPairCache,
+      collisionConfiguration);
+  }
+  // Only active objects get their AABBs refreshed each frame, which leaves
+  // still ones in the broadphase's fixed set
+  collisionWorld->setForceUpdateAllAabbs(false);
+  lastCollisionTick = 0;
+}
+
+void CoreScene::DestroyCollisionWorld() {
+  delete collisionWorld;
   delete solver;
   delete overlappingPairCache;
   delete dispatcher;
+  DeleteCollisionThreadSupport(collisionThreadSupport);
   delete collisionConfiguration;
+  collisionWorld = NULL;
+  dynamicsWorld = NULL;
+  solver = NULL;
+  collisionThreadSupport = NULL;
 }
 
-bool CoreScene::RemoveModel(JSContext* cx, CoreModel* model) {
-  // Find the index of the model to remove
-  int idx = -1;
-  for (int i = 0; i < children.GetSizeI(); ++i) {
-    JS::RootedObject childObj(cx, &children[i].toObject());
-    CoreModel* child = GetCoreModel(childObj);
-    if (child->id == model->id) {
-      idx = i;
-      break;
-    }
+bool CoreScene::ConfigureCollisions(JSContext* cx, bool dynamics, int threads, bool threaded) {
+  threads = OVR::Alg::Clamp(threads, 0, MAX_COLLISION_THREADS);
+  if (threads > 0 && collisionThreadSupport == NULL && collisionThreadSupportTaken) {
+    JS_ReportError(cx, "Only one scene at a time can use collisionThreads");
+    return false;
   }
 
-  // If we found it, hooray
-  if (idx != -1) {
-    children.RemoveAt(idx);
+  WaitForCollisions();
+  if (threaded && collisionThread == NULL) {
+    collisionThread = new CollisionThread();
+  } else if (!threaded && collisionThread != NULL) {
+    delete collisionThread;
+    collisionThread = NULL;
+  }
+
+  if ((dynamicsWorld != NULL) == dynamics && collisionThreads == threads) {
     return true;
   }
 
-  // Otherwise, recurse
+  // Pull every collision object out of the old world, then put them back
+  // into the new one
+  UpdateGraph(cx);
+  for (int i = 0; i < graph.GetSizeI(); ++i) {
+    graph.nodes[i]->StopCollisions();
+  }
+  DestroyCollisionWorld();
+  CreateCollisionWorld(dynamics, threads);
   for (int i = 0; i < children.GetSizeI(); ++i) {
     JS::RootedObject childObj(cx, &children[i].toObject());
-    CoreModel* child = GetCoreModel(childObj);
-    if (child->RemoveModel(cx, model)) {
-      return true;
-    }
+    GetCoreModel(childObj)->StartCollisions(cx);
+  }
+  return true;
+}
+
+bool CoreScene::RemoveModel(JSContext* cx, CoreModel* model) {
+  if (model->scene != this) {
+    return false;
+  }
+  OVR::Array<JS::Heap<JS::Value>>& siblings = model->parent == NULL ? children : model->parent->children;
+  if (!SwapRemoveChild(cx, siblings, model)) {
+    return false;
+  }
+  graph.Detach(model);
+  UnregisterModel(cx, model);
+  return true;
+}
+
+void CoreScene::RegisterModel(JSContext* cx, CoreModel* model) {
+  model->scene = this;
+  modelsById.Set(model->id, model);
+  for (int i = 0; i < model->children.GetSizeI(); ++i) {
+    JS::RootedObject childObj(cx, &model->children[i].toObject());
+    RegisterModel(cx, GetCoreModel(childObj));
+  }
+}
+
+void CoreScene::UnregisterModel(JSContext* cx, CoreModel* model) {
+  // Collision objects have to leave the world while we can still reach it
+  model->StopCollisions();
+  model->scene = NULL;
+  modelsById.Remove(model->id);
+  for (int i = 0; i < model->children.GetSizeI(); ++i) {
+    JS::RootedObject childObj(cx, &model->children[i].toObject());
+    UnregisterModel(cx, GetCoreModel(childObj));
+  }
+}
+
+void CoreScene::UpdateGraph(JSContext* cx) {
+  if (!graph.IsDirty()) {
+    return;
   }
 
-  return false;
+  OVR::Array<CoreModel*> oldNodes(graph.nodes);
+  graph.Rebuild(cx, children);
+
+  // Anything that didn't make it into the new graph has left the scene, and
+  // is no longer kept alive by it, so drop every reference we hold to it
+  for (int i = 0; i < oldNodes.GetSizeI(); ++i) {
+    CoreModel* node = oldNodes[i];
+    if (node->graphIndex == -1) {
+      gazeBroadphase.Remove(node);
+    }
+  }
+  for (int i = gazeActive.GetSizeI() - 1; i >= 0; --i) {
+    if (gazeActive[i]->graphIndex == -1) {
+      gazeActive.RemoveAt(i);
+    }
+  }
 }
 
 void CoreScene::ComputeMatrices(JSContext* cx) {
-  OVR::Matrix4f transform;
-  for (int i = 0; i < children.GetSizeI(); ++i) {
-    JS::RootedObject childObj(cx, &children[i].toObject());
-    CoreModel* child = GetCoreModel(childObj);
-    child->ComputeMatrices(cx, transform);
+  UpdateGraph(cx);
+
+  // Only recompute models that changed themselves or sit under one that did
+  graph.composeIndices.Clear();
+  graph.worldIndices.Clear();
+  for (int i = 0; i < graph.GetSizeI(); ++i) {
+    int parent = graph.parents[i];
+    CoreModel* node = graph.nodes[i];
+    bool parentChanged = parent != -1 && graph.worldChanged[parent];
+    bool selfChanged = node->TransformChanged();
+    if (selfChanged) {
+      node->GatherTransform(cx, graph.transforms, i);
+      graph.composeIndices.PushBack(i);
+    }
+    graph.worldChanged[i] = selfChanged || parentChanged;
+    if (graph.worldChanged[i]) {
+      graph.worldIndices.PushBack(i);
+    }
+  }
+
+  if (graph.worldIndices.GetSizeI() > 0) {
+    ComputeWorldMatrices();
+  }
+
+  // Refresh the bounds of anything that moved or changed what it draws
+  for (int i = 0; i < graph.GetSizeI(); ++i) {
+    if (graph.IsLive(i)) {
+      graph.nodes[i]->UpdateWorldBounds(cx, graph.worldChanged[i]);
+    }
+  }
+  graph.ComputeSubtreeBounds();
+}
+
+void CoreScene::ComputeWorldMatrices() {
+  TransformKernel_ComposeLocal(
+    graph.transforms,
+    graph.composeIndices.GetDataPtr(),
+    graph.composeIndices.GetSizeI(),
+    graph.localMatrices.GetDataPtr());
+  TransformKernel_ComputeWorld(
+    graph.parents.GetDataPtr(),
+    graph.localMatrices.GetDataPtr(),
+    graph.worldMatrices.GetDataPtr(),
+    graph.worldIndices.GetDataPtr(),
+    graph.worldIndices.GetSizeI());
+
+  for (int n = 0; n < graph.worldIndices.GetSizeI(); ++n) {
+    int i = graph.worldIndices[n];
+    graph.nodes[i]->localMatrix = graph.localMatrices[i];
+    graph.nodes[i]->worldMatrix = graph.worldMatrices[i];
+    graph.nodes[i]->collisionTransformDirty = true;
   }
 }
 
 void CoreScene::CallFrameCallbacks(JSContext* cx, JS::HandleValue ev) {
-  for (int i = 0; i < children.GetSizeI(); ++i) {
-    JS::RootedObject childObj(cx, &children[i].toObject());
-    CoreModel* child = GetCoreModel(childObj);
-    child->CallFrameCallbacks(cx, ev);
+  UpdateGraph(cx);
+  for (int i = 0; i < graph.GetSizeI(); ++i) {
+    if (graph.IsLive(i)) {
+      graph.nodes[i]->CallFrameCallbacks(cx, ev);
+    }
   }
 }
 
 void CoreScene::CallGazeCallbacks(JSContext* cx, OVR::OvrGuiSys* guiSys, OVR::Vector3f* viewPos, OVR::Vector3f* viewFwd, const OVR::VrFrame& vrFrame, JS::HandleValue ev) {
-  for (int i = 0; i < children.GetSizeI(); ++i) {
-    JS::RootedObject childObj(cx, &children[i].toObject());
-    CoreModel* child = GetCoreModel(childObj);
-    child->CallGazeCallbacks(cx, guiSys, viewPos, viewFwd, vrFrame, ev);
+  const float GAZE_MAX_DISTANCE = 10000.0f;
+
+  UpdateGraph(cx);
+
+  // Keep the broadphase in step with the models that want gaze events
+  for (int i = 0; i < graph.GetSizeI(); ++i) {
+    CoreModel* node = graph.nodes[i];
+    bool wantsGaze = graph.IsLive(i) && (node->HasGazeCallback() || node->HasGestureCallback());
+    if (!wantsGaze) {
+      gazeBroadphase.Remove(node);
+    } else if (node->gazeLeaf == NULL || node->gazeBoundsDirty || graph.worldChanged[i]) {
+      if (node->UpdateGazeBounds(cx, guiSys)) {
+        gazeBroadphase.Update(node, node->gazeBounds);
+      } else {
+        gazeBroadphase.Remove(node);
+      }
+    }
+  }
+
+  OVR::Array<GazeCandidate> candidates;
+  gazeBroadphase.Query(*viewPos, *viewFwd, GAZE_MAX_DISTANCE, candidates);
+
+  // Whatever was hovered or touched has to be revisited too, so it can hear
+  // about the gaze leaving it
+  for (int i = 0; i < gazeActive.GetSizeI(); ++i) {
+    bool found = false;
+    for (int j = 0; j < candidates.GetSizeI(); ++j) {
+      if (candidates[j].model == gazeActive[i]) {
+        found = true;
+        break;
+      }
+    }
+    if (!found) {
+      GazeCandidate candidate;
+      candidate.model = gazeActive[i];
+      candidate.t = FLT_MAX;
+      candidates.PushBack(candidate);
+    }
+  }
+
+  gazeActive.Clear();
+  for (int i = 0; i < candidates.GetSizeI(); ++i) {
+    CoreModel* node = candidates[i].model;
+    // A callback may have taken it out of the scene
+    if (node->graphIndex == -1 || !graph.IsLive(node->graphIndex)) {
+      continue;
+    }
+    node->CallGazeCallbacks(cx, guiSys, viewPos, viewFwd, vrFrame, ev);
+    if (node->isHovered || node->isTouching) {
+      gazeActive.PushBack(node);
+    }
   }
 }
 
-void CoreScene::PerformCollisionDetection(JSContext* cx, double now, JS::HandleValue ev) {
-  // Update transforms
-  for (int i = 0; i < children.GetSizeI(); ++i) {
-    JS::RootedObject childObj(cx, &children[i].toObject());
-    CoreModel* child = GetCoreModel(childObj);
-    child->UpdateCollisionObjects(cx);
+void CoreScene::WaitForCollisions() {
+  if (collisionThread != NULL) {
+    collisionThread->Wait();
+  }
+}
+
+void CoreScene::SyncCollisionObjects(JSContext* cx) {
+  for (int i = 0; i < graph.GetSizeI(); ++i) {
+    if (graph.IsLive(i)) {
+      graph.nodes[i]->collisionOverlapping = false;
+    }
+  }
+
+  // The last pass's broadphase pairs say who is touching something, which
+  // decides whether still kinematics can sleep
+  btBroadphasePairArray& overlaps = collisionWorld->getPairCache()->getOverlappingPairArray();
+  for (int i = 0; i < overlaps.size(); ++i) {
+    btBroadphaseProxy* proxies[2] = { overlaps[i].m_pProxy0, overlaps[i].m_pProxy1 };
+    for (int side = 0; side < 2; ++side) {
+      const btCollisionObject* obj = static_cast<const btCollisionObject*>(proxies[side]->m_clientObject);
+      CoreModel* model = ModelById(obj->getUserIndex());
+      if (model != NULL) {
+        model->collisionOverlapping = true;
+      }
+    }
   }
 
-  // Advance the simulation
+  for (int i = 0; i < graph.GetSizeI(); ++i) {
+    if (graph.IsLive(i)) {
+      graph.nodes[i]->UpdateCollisionObjects(cx);
+    }
+  }
+}
+
+void CoreScene::PerformCollisionDetection(JSContext* cx, double now, JS::HandleValue ev) {
+  UpdateGraph(cx);
+
   btScalar tickTime = btScalar(1.0) / btScalar(60.0);
-  if (lastCollisionTick == 0) {
-    dynamicsWorld->stepSimulation(tickTime, 3, tickTime);
+  btScalar dt = lastCollisionTick == 0 ? tickTime : btScalar(now - lastCollisionTick);
+  lastCollisionTick = now;
+
+  if (collisionThread != NULL) {
+    // Collect the pass started last frame, then start one over this frame's
+    // transforms to run while we record and render
+    collisionThread->Wait();
+    collisionPairs = collisionThread->pairs;
+    SyncCollisionObjects(cx);
+    collisionThread->Kick(collisionWorld, dynamicsWorld, dt);
   } else {
-    dynamicsWorld->stepSimulation(now - lastCollisionTick, 3, tickTime);
+    SyncCollisionObjects(cx);
+    CollisionPass(collisionWorld, dynamicsWorld, dt, collisionPairs);
   }
-  lastCollisionTick = now;
 
-  // Check for collisions
-  int numManifolds = dispatcher->getNumManifolds();
-  for (int i = 0; i < numManifolds; ++i) {
-    btPersistentManifold* contactManifold = dispatcher->getManifoldByIndexInternal(i);
-    const btCollisionObject* obA = static_cast<const btCollisionObject*>(contactManifold->getBody0());
-    const btCollisionObject* obB = static_cast<const btCollisionObject*>(contactManifold->getBody1());
-    CoreModel* modelA = ModelById(cx, obA->getUserIndex());
-    CoreModel* modelB = ModelById(cx, obB->getUserIndex());
-    modelA->CollidedWith(cx, modelB, ev);
-    modelB->CollidedWith(cx, modelA, ev);
+  DeliverCollisionEvents(cx, ev);
+}
+
+void CoreScene::DeliverCollisionEvents(JSContext* cx, JS::HandleValue ev) {
+  // Keep the pairs whose models are still here and want to hear about it
+  int kept = 0;
+  for (int i = 0; i < collisionPairs.GetSizeI(); ++i) {
+    CoreModel* modelA = ModelById((int)(collisionPairs[i] >> 32));
+    CoreModel* modelB = ModelById((int)(collisionPairs[i] & 0xFFFFFFFF));
+    if (modelA == NULL || modelB == NULL) {
+      continue;
+    }
+    if (!modelA->CheckCollision(cx, modelB) || !modelB->CheckCollision(cx, modelA)) {
+      continue;
+    }
+    collisionPairs[kept++] = collisionPairs[i];
+  }
+  collisionPairs.Resize(kept);
+  OVR::Alg::QuickSort(collisionPairs);
+  int unique = 0;
+  for (int i = 0; i < collisionPairs.GetSizeI(); ++i) {
+    if (unique == 0 || collisionPairs[i] != collisionPairs[unique - 1]) {
+      collisionPairs[unique++] = collisionPairs[i];
+    }
   }
+  collisionPairs.Resize(unique);
+
+  // Walk both sorted lists together; pairs only in this frame's list have
+  // started colliding, and pairs only in last frame's have stopped
+  int cur = 0;
+  int last = 0;
+  while (cur < collisionPairs.GetSizeI() || last < lastCollisionPairs.GetSizeI()) {
+    bool started;
+    uint64_t pair;
+    if (last >= lastCollisionPairs.GetSizeI() || (cur < collisionPairs.GetSizeI() && collisionPairs[cur] < lastCollisionPairs[last])) {
+      started = true;
+      pair = collisionPairs[cur++];
+    } else if (cur >= collisionPairs.GetSizeI() || lastCollisionPairs[last] < collisionPairs[cur]) {
+      started = false;
+      pair = lastCollisionPairs[last++];
+    } else {
+      // Still colliding
+      ++cur;
+      ++last;
+      continue;
+    }
 
-  // Finish collision detection
-  for (int i = 0; i < children.GetSizeI(); ++i) {
-    JS::RootedObject childObj(cx, &children[i].toObject());
-    CoreModel* child = GetCoreModel(childObj);
-    child->FinishCollisions(cx, ev);
+    // Tell both sides, looking them up each time since callbacks can remove models
+    int ids[2] = { (int)(pair >> 32), (int)(pair & 0xFFFFFFFF) };
+    for (int side = 0; side < 2; ++side) {
+      CoreModel* model = ModelById(ids[side]);
+      if (model == NULL) {
+        continue;
+      }
+      CoreModel* other = ModelById(ids[1 - side]);
+      if (started) {
+        model->CallCollideCallback(cx, model->onCollideStartVal, "onCollideStart", other, ev);
+      } else {
+        model->CallCollideCallback(cx, model->onCollideEndVal, "onCollideEnd", other, ev);
+      }
+    }
   }
+
+  // This frame's pairs are what the next one gets compared against
+  lastCollisionPairs = collisionPairs;
 }
 
-void CoreScene::DrawEyeView(JSContext* cx, OVR::OvrGuiSys* guiSys, const int eye, const OVR::Matrix4f& eyeViewMatrix, const OVR::Matrix4f& eyeProjectionMatrix, const OVR::Matrix4f& eyeViewProjection, ovrFrameParms& frameParms) {
+void CoreScene::RecordDrawList(JSContext* cx, OVR::OvrGuiSys* guiSys, const ViewFrustum& frustum) {
+  drawList.Clear();
+
   JS::RootedObject rootedClearColorVal(cx, &clearColorVal->toObject());
-  OVR::Vector4f* clearClr = GetVector4f(rootedClearColorVal);
-  glClearColor(clearClr->x, clearClr->y, clearClr->z, clearClr->w);
-  glClear(GL_COLOR_BUFFER_BIT);
+  OVR::Vector4f* clearColor = GetVector4f(rootedClearColorVal);
+  if (clearColor != NULL) {
+    drawList.clearColor = *clearColor;
+  }
 
-  // Render the background texture if it exists
+  // Resolve the background texture if it exists
   if (backgroundVal != NULL && !backgroundVal->isNullOrUndefined() && backgroundVal->isObject()) {
     JS::RootedObject bkgObj(cx, &backgroundVal->toObject());
     CoreTexture* tex = GetCoreTexture(bkgObj);
     if (tex != NULL) {
-      // Set which texture we're working on
-      glActiveTexture(GL_TEXTURE0);
+      drawList.hasBackground = true;
+      drawList.backgroundCube = tex->cube;
+      drawList.background.target = tex->texture.target;
+      drawList.background.texture = tex->texture.texture;
+    }
+  }
+
+  // If a callback changed the tree since the matrices were computed, bring
+  // the new graph's matrices and bounds up to date before culling with them
+  if (graph.IsDirty() || !graph.boundsValid) {
+    ComputeMatrices(cx);
+  }
 
-      // Bind the texture
-      glBindTexture(tex->texture.target, tex->texture.texture);
+  int i = 0;
+  while (i < graph.GetSizeI()) {
+    if (!graph.IsLive(i)) {
+      ++i;
+      continue;
+    }
 
-      // enable sRGB if we've got it
-      if (HasEXT_sRGB_texture_decode) {
-        glTexParameteri(tex->texture.target, GL_TEXTURE_SRGB_DECODE_EXT, GL_DECODE_EXT);
-      }
+    // Skip whole subtrees that are out of view
+    const OVR::Vector4f& sphere = graph.subtreeSpheres[i];
+    if (frustum.CullsSphere(OVR::Vector3f(sphere.x, sphere.y, sphere.z), sphere.w)) {
+      drawList.culledCount += graph.subtreeDrawables[i];
+      i = graph.subtreeEnds[i];
+      continue;
+    }
 
-      // Choose the correct program based on whether the texture is a cubemap
-      OVR::GlProgram prog = tex->cube ? cubeProgram : panoProgram;
+    CoreModel* node = graph.nodes[i];
+    if (node->boundsGeometry != NULL && frustum.CullsSphere(node->worldCenter, node->worldRadius)) {
+      drawList.culledCount++;
+    } else {
+      node->RecordDraw(cx, guiSys, drawList);
+    }
+    ++i;
+  }
 
-      // Use the program (at 100% brightness)
-      glUseProgram(prog.program);
-      glUniform4f(prog.uColor, 1.0f, 1.0f, 1.0f, 1.0f);
+  // Group draws by state so replaying them changes as little as possible
+  drawList.Sort(frustum.viewMatrix);
+}
 
-      // Pass in our eye view projection matrix
-      glUniformMatrix4fv(prog.uMvp, 1, GL_TRUE, eyeViewProjection.M[0]);
+void CoreScene::DrawEyeView(const int eye, const OVR::Matrix4f& eyeViewMatrix, const OVR::Matrix4f& eyeProjectionMatrix, const OVR::Matrix4f& eyeViewProjection, ovrFrameParms& frameParms) {
+  const OVR::Vector4f& clearClr = drawList.clearColor;
+  glClearColor(clearClr.x, clearClr.y, clearClr.z, clearClr.w);
+  glClear(GL_COLOR_BUFFER_BIT);
 
-      // Draw the background texture on the surrounding globe
-      globe.Draw();
+  // Render the background texture if it exists
+  if (drawList.hasBackground) {
+    const DrawTexture& tex = drawList.background;
+
+    // Set which texture we're working on
+    glActiveTexture(GL_TEXTURE0);
 
-      // Unbind the texture
-      glBindTexture(tex->texture.target, 0);
+    // Bind the texture
+    glBindTexture(tex.target, tex.texture);
 
-      // Configure frame parms (mostly cargo cult from OVR example program)
-      frameParms.Flags = 0; // srgb
-      frameParms.LayerCount = 1;
-      frameParms.Layers[VRAPI_FRAME_LAYER_TYPE_WORLD].SrcBlend = VRAPI_FRAME_LAYER_BLEND_ONE;
-      frameParms.Layers[VRAPI_FRAME_LAYER_TYPE_WORLD].DstBlend = VRAPI_FRAME_LAYER_BLEND_ZERO;
-      frameParms.Layers[VRAPI_FRAME_LAYER_TYPE_WORLD].Flags &= ~VRAPI_FRAME_LAYER_FLAG_WRITE_ALPHA;
-      frameParms.Layers[VRAPI_FRAME_LAYER_TYPE_OVERLAY].Textures[eye].ColorTextureSwapChain = NULL;
-      OVR::GL_CheckErrors("draw");
+    // enable sRGB if we've got it
+    if (HasEXT_sRGB_texture_decode) {
+      glTexParameteri(tex.target, GL_TEXTURE_SRGB_DECODE_EXT, GL_DECODE_EXT);
     }
-  }
 
-  for (int i = 0; i < children.GetSizeI(); ++i) {
-    JS::RootedObject childObj(cx, &children[i].toObject());
-    CoreModel* child = GetCoreModel(childObj);
-    child->DrawEyeView(cx, guiSys, eye, eyeViewMatrix, eyeProjectionMatrix, eyeViewProjection, frameParms);
+    // Choose the correct program based on whether the texture is a cubemap
+    OVR::GlProgram prog = drawList.backgroundCube ? cubeProgram : panoProgram;
+
+    // Use the program (at 100% brightness)
+    glUseProgram(prog.program);
+    glUniform4f(prog.uColor, 1.0f, 1.0f, 1.0f, 1.0f);
+
+    // Pass in our eye view projection matrix
+    glUniformMatrix4fv(prog.uMvp, 1, GL_TRUE, eyeViewProjection.M[0]);
+
+    // Draw the background texture on the surrounding globe
+    globe.Draw();
+
+    // Unbind the texture
+    glBindTexture(tex.target, 0);
+
+    // Configure frame parms (mostly cargo cult from OVR example program)
+    frameParms.Flags = 0; // srgb
+    frameParms.LayerCount = 1;
+    frameParms.Layers[VRAPI_FRAME_LAYER_TYPE_WORLD].SrcBlend = VRAPI_FRAME_LAYER_BLEND_ONE;
+    frameParms.Layers[VRAPI_FRAME_LAYER_TYPE_WORLD].DstBlend = VRAPI_FRAME_LAYER_BLEND_ZERO;
+    frameParms.Layers[VRAPI_FRAME_LAYER_TYPE_WORLD].Flags &= ~VRAPI_FRAME_LAYER_FLAG_WRITE_ALPHA;
+    frameParms.Layers[VRAPI_FRAME_LAYER_TYPE_OVERLAY].Textures[eye].ColorTextureSwapChain = NULL;
+    OVR::GL_CheckErrors("draw");
   }
 
-  glBindVertexArray(0);
-  glUseProgram(0);
+  drawList.Draw(eyeViewMatrix, eyeProjectionMatrix);
 }
 
-// TODO: (PERF) Make this a hash lookup rather than a recursive search
-CoreModel* CoreScene::ModelById(JSContext* cx, int id) {
-  for (int i = 0; i < children.GetSizeI(); ++i) {
-    JS::RootedObject childObj(cx, &children[i].toObject());
-    CoreModel* child = GetCoreModel(childObj);
-    CoreModel* model = child->ModelById(cx, id);
-    if (model != NULL) {
-      return model;
-    }
-  }
-  return NULL;
+CoreModel* CoreScene::ModelById(int id) {
+  CoreModel** model = modelsById.Get(id);
+  return model == NULL ? NULL : *model;
 }
 
 OVR::Vector4f* VRJS_MEMBER(CoreScene, clearColor, GetVector4f);
@@ -238,9 +572,27 @@ OVR::Vector4f* VRJS_MEMBER(CoreScene, clearColor, GetVector4f);
 VRJS_GETSET(CoreScene, clearColor);
 VRJS_GETSET(CoreScene, background);
 
+static bool CoreScene_get_culledCount(JSContext* cx, unsigned argc, JS::Value *vp) {
+  JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
+  JS::RootedObject self(cx, &args.thisv().toObject());
+  CoreScene* scene = GetCoreScene(self);
+  args.rval().set(JS::Int32Value(scene == NULL ? 0 : scene->drawList.culledCount));
+  return true;
+}
+
+static bool CoreScene_get_drawnCount(JSContext* cx, unsigned argc, JS::Value *vp) {
+  JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
+  JS::RootedObject self(cx, &args.thisv().toObject());
+  CoreScene* scene = GetCoreScene(self);
+  args.rval().set(JS::Int32Value(scene == NULL ? 0 : scene->drawList.items.GetSizeI()));
+  return true;
+}
+
 static JSPropertySpec CoreScene_props[] = {
   VRJS_PROP(CoreScene, clearColor),
   VRJS_PROP(CoreScene, background),
+  JS_PSG("culledCount", CoreScene_get_culledCount, JSPROP_PERMANENT | JSPROP_ENUMERATE),
+  JS_PSG("drawnCount", CoreScene_get_drawnCount, JSPROP_PERMANENT | JSPROP_ENUMERATE),
   JS_PS_END
 };
 
@@ -261,31 +613,24 @@ static JSClass coreSceneClass = {
   CoreScene_trace
 };
 
+static JS::PersistentRootedObject coreSceneProto;
+
+static JSFunctionSpec CoreScene_methods[] = {
+  JS_FN("add", CoreScene_add, 0, 0),
+  JS_FN("remove", CoreScene_remove, 0, 0),
+  JS_FN("configure", CoreScene_configure, 0, 0),
+  JS_FN("setClearColor", CoreScene_setClearColor, 0, 0),
+  JS_FS_END
+};
+
 JSObject* NewCoreScene(JSContext* cx, CoreScene* scene) {
-  JS::RootedObject self(cx, JS_NewObject(cx, &coreSceneClass));  
+  JS::RootedObject self(cx, JS_NewObjectWithGivenProto(cx, &coreSceneClass, coreSceneProto));
   JS_SetPrivate(self, (void *)scene);
 
-  if (!JS_DefineProperties(cx, self, CoreScene_props)) {
-    __android_log_print(ANDROID_LOG_ERROR, LOG_COMPONENT, "Could not define properties on scene\n");
-  }
-
   // Set a white clear color by default
   JS::RootedValue clearColor(cx, JS::ObjectOrNullValue(
-    NewCoreVector4f(cx, new OVR::Vector4f(1, 1, 1, 1))));
+    NewCoreVector4f(cx, OVR::Vector4f(1, 1, 1, 1))));
   scene->clearColorVal = new JS::Heap<JS::Value>(clearColor);
-  
-  if (!JS_DefineFunction(cx, self, "add", &CoreScene_add, 0, 0)) {
-    JS_ReportError(cx, "Could not create scene.add function");
-    return NULL;
-  }
-  if (!JS_DefineFunction(cx, self, "remove", &CoreScene_remove, 0, 0)) {
-    JS_ReportError(cx, "Could not create scene.remove function");
-    return NULL;
-  }
-  if (!JS_DefineFunction(cx, self, "setClearColor", &CoreScene_setClearColor, 0, 0)) {
-    JS_ReportError(cx, "Could not create scene.setClearColor function");
-    return NULL;
-  }
 
   JS::RootedObject objects(cx, JS_NewArrayObject(cx, 0));
   JS::RootedValue objectsVal(cx, JS::ObjectOrNullValue(objects));
@@ -298,6 +643,10 @@ JSObject* NewCoreScene(JSContext* cx, CoreScene* scene) {
 }
 
 CoreScene* GetCoreScene(JS::HandleObject obj) {
+  // The prototype and objects of other classes have no payload for us
+  if (JS_GetClass(obj) != &coreSceneClass) {
+    return NULL;
+  }
   CoreScene* scene = (CoreScene*)JS_GetPrivate(obj);
   return scene;
 }
@@ -326,18 +675,30 @@ bool CoreScene_add(JSContext* cx, unsigned argc, JS::Value *vp) {
 
   JS::RootedObject modelObj(cx, &args[0].toObject());
   CoreModel* model = GetCoreModel(modelObj);
+  if (model == NULL) {
+    JS_ReportError(cx, "Expected a model argument");
+    return false;
+  }
 
   JS::RootedObject thisObj(cx, &args.thisv().toObject());
-  CoreScene* scene = (CoreScene*)JS_GetPrivate(thisObj);
+  CoreScene* scene = GetCoreScene(thisObj);
+  if (scene == NULL) {
+    return ReportWrongThis(cx, "Scene");
+  }
+
+  // A model only hangs in one place, so take it out of its old one first
+  model->Unlink(cx);
 
-  // Annotate the scene object on the model
-  model->scene = scene;
+  // Link it in, and index it along with everything below it
+  model->parent = NULL;
+  model->childIndex = scene->children.GetSizeI();
+  scene->children.PushBack(JS::Heap<JS::Value>(args[0]));
+  scene->RegisterModel(cx, model);
+  scene->graph.MarkDirty();
 
   // Make sure collision detection is set up and configured
   model->StartCollisions(cx);
 
-  scene->children.PushBack(JS::Heap<JS::Value>(args[0]));
-
   return true;
 }
 
@@ -356,16 +717,18 @@ bool CoreScene_remove(JSContext* cx, unsigned argc, JS::Value *vp) {
 
   JS::RootedObject modelObj(cx, &args[0].toObject());
   CoreModel* model = GetCoreModel(modelObj);
+  if (model == NULL) {
+    JS_ReportError(cx, "Expected a model argument");
+    return false;
+  }
 
   JS::RootedObject thisObj(cx, &args.thisv().toObject());
-  CoreScene* scene = (CoreScene*)JS_GetPrivate(thisObj);
-
-  // Remove the scene object from the model
-  model->scene = nullptr;
-
-  // Make sure collision detection is stopped
-  model->StopCollisions();
+  CoreScene* scene = GetCoreScene(thisObj);
+  if (scene == NULL) {
+    return ReportWrongThis(cx, "Scene");
+  }
 
+  // Unlinks the model, and stops collision detection for its whole subtree
   if (!scene->RemoveModel(cx, model)) {
     JS_ReportError(cx, "Could not find model to remove");
     return false;
@@ -374,6 +737,76 @@ bool CoreScene_remove(JSContext* cx, unsigned argc, JS::Value *vp) {
   return true;
 }
 
+bool CoreScene_configure(JSContext* cx, unsigned argc, JS::Value *vp) {
+  JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
+
+  // Check the arguments length
+  if (args.length() != 1) {
+    JS_ReportError(cx, "Wrong number of arguments: %d, was expecting: %d", argc, 1);
+    return false;
+  }
+  if (!args[0].isObject()) {
+    JS_ReportError(cx, "Expected configure to take an options object");
+    return false;
+  }
+
+  JS::RootedObject options(cx, &args[0].toObject());
+  JS::RootedObject thisObj(cx, &args.thisv().toObject());
+  CoreScene* scene = GetCoreScene(thisObj);
+  if (scene == NULL) {
+    return ReportWrongThis(cx, "Scene");
+  }
+
+  // Rigid body dynamics, off by default since we only report collisions
+  JS::RootedValue dynamics(cx);
+  if (!JS_GetProperty(cx, options, "dynamics", &dynamics)) {
+    return false;
+  }
+  bool useDynamics = scene->dynamicsWorld != NULL;
+  if (!dynamics.isUndefined()) {
+    useDynamics = JS::ToBoolean(dynamics);
+  }
+
+  // Narrowphase worker threads, where 0 runs it on the thread doing the pass
+  JS::RootedValue threads(cx);
+  if (!JS_GetProperty(cx, options, "collisionThreads", &threads)) {
+    return false;
+  }
+  int collisionThreads = scene->collisionThreads;
+  if (!threads.isUndefined()) {
+    if (!threads.isNumber()) {
+      JS_ReportError(cx, "Expected collisionThreads to be a number");
+      return false;
+    }
+    collisionThreads = (int)threads.toNumber();
+  }
+
+  // Run the whole pass on its own thread, a frame behind
+  JS::RootedValue thread(cx);
+  if (!JS_GetProperty(cx, options, "collisionThread", &thread)) {
+    return false;
+  }
+  bool threaded = scene->collisionThread != NULL;
+  if (!thread.isUndefined()) {
+    threaded = JS::ToBoolean(thread);
+  }
+
+  if (!scene->ConfigureCollisions(cx, useDynamics, collisionThreads, threaded)) {
+    return false;
+  }
+
+  // A new ev object every frame instead of one updated in place
+  JS::RootedValue freshFrameEvents(cx);
+  if (!JS_GetProperty(cx, options, "freshFrameEvents", &freshFrameEvents)) {
+    return false;
+  }
+  if (!freshFrameEvents.isUndefined()) {
+    scene->freshFrameEvents = JS::ToBoolean(freshFrameEvents);
+  }
+
+  return true;
+}
+
 bool CoreScene_setClearColor(JSContext* cx, unsigned argc, JS::Value *vp) {
   JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
 
@@ -389,6 +822,9 @@ bool CoreScene_setClearColor(JSContext* cx, unsigned argc, JS::Value *vp) {
 
   JS::RootedObject self(cx, &args.thisv().toObject());
   CoreScene* scene = GetCoreScene(self);
+  if (scene == NULL) {
+    return ReportWrongThis(cx, "Scene");
+  }
 
   scene->clearColorVal = new JS::Heap<JS::Value>(args[0]);
 
@@ -426,6 +862,7 @@ void CoreScene_trace(JSTracer *tracer, JSObject *obj) {
   __android_log_print(ANDROID_LOG_DEBUG, LOG_COMPONENT, "Tracing scene\n");
   CoreScene* scene = (CoreScene*)JS_GetPrivate(obj);
   if (scene != NULL) {
+    scene->graph.Trace(tracer);
     TraceHeap(tracer, scene->clearColorVal, "scene", "clearColorVal");
     TraceHeap(tracer, scene->backgroundVal, "scene", "backgroundVal");
     for (int i = 0; i < scene->children.GetSizeI(); ++i) {
@@ -441,18 +878,19 @@ CoreScene* SetupCoreScene(JSContext* cx, JS::RootedObject* global, JS::RootedObj
   JSObject *obj = JS_InitClass(
       cx,
       *core,
-      *global,
+      nullptr,
       &coreSceneClass,
       CoreScene_constructor,
       0,
-      nullptr, /* Properties */
-      nullptr, /* Methods */
+      CoreScene_props, /* Properties */
+      CoreScene_methods, /* Methods */
       nullptr, /* Static Props */
       nullptr  /* Static Methods */);
   if (!obj) {
     __android_log_print(ANDROID_LOG_ERROR, LOG_COMPONENT, "Could not construct env.core.Scene class\n");
     return NULL;
   }
+  coreSceneProto.init(cx, obj);
 
   CoreScene* scene = new CoreScene();
   JS::RootedObject sceneObj(cx, NewCoreScene(cx, scene));
@@ -470,4 +908,79 @@ CoreScene* SetupCoreScene(JSContext* cx, JS::RootedObject* global, JS::RootedObj
   }
 
   return scene;
-}
\ No newline at end of file
+}
+
+#ifdef FLINT_BENCHMARK
+
+static float RandomFloat(float range) {
+  return ((float)rand() / (float)RAND_MAX) * range;
+}
+
+static void BenchmarkCollisionThreads(int colliders, int threads) {
+  const int ROUNDS = 20;
+
+  // Unit cubes packed tightly enough that most of them touch a few others,
+  // all sharing one hull like models sharing a geometry do
+  srand(1);
+  btConvexHullShape cube;
+  for (int i = 0; i < 8; ++i) {
+    cube.addPoint(btVector3(i & 1 ? 0.5f : -0.5f, i & 2 ? 0.5f : -0.5f, i & 4 ? 0.5f : -0.5f), false);
+  }
+  cube.recalcLocalAabb();
+  float extent = powf((float)colliders, 1.0f / 3.0f) * 0.8f;
+
+  btDefaultCollisionConfiguration config;
+  btThreadSupportInterface* threadSupport;
+  btCollisionDispatcher* dispatcher = NewCollisionDispatcher(&config, threads, &threadSupport);
+  btDbvtBroadphase broadphase;
+  btCollisionWorld* world = new btCollisionWorld(dispatcher, &broadphase, &config);
+
+  OVR::Array<btCollisionObject*> objects;
+  for (int i = 0; i < colliders; ++i) {
+    btCollisionObject* obj = new btCollisionObject();
+    obj->setCollisionShape(&cube);
+    obj->setCollisionFlags(btCollisionObject::CF_KINEMATIC_OBJECT);
+    obj->setActivationState(DISABLE_DEACTIVATION);
+    btTransform transform;
+    transform.setIdentity();
+    transform.setOrigin(btVector3(RandomFloat(extent), RandomFloat(extent), RandomFloat(extent)));
+    obj->setWorldTransform(transform);
+    world->addCollisionObject(obj);
+    objects.PushBack(obj);
+  }
+
+  // Warm up the pair cache, then time frames where everything moves a little
+  world->performDiscreteCollisionDetection();
+  double start = vrapi_GetTimeInSeconds();
+  for (int round = 0; round < ROUNDS; ++round) {
+    for (int i = 0; i < objects.GetSizeI(); ++i) {
+      btTransform& transform = objects[i]->getWorldTransform();
+      transform.setOrigin(transform.getOrigin() + btVector3(0.01f, 0.0f, 0.0f));
+    }
+    world->performDiscreteCollisionDetection();
+  }
+  double seconds = (vrapi_GetTimeInSeconds() - start) / ROUNDS;
+
+  __android_log_print(ANDROID_LOG_INFO, LOG_COMPONENT,
+    "Collision benchmark: %d colliders, %d threads, %d manifolds, %.3fms per frame\n",
+    colliders, threads, dispatcher->getNumManifolds(), seconds * 1000.0);
+
+  for (int i = 0; i < objects.GetSizeI(); ++i) {
+    world->removeCollisionObject(objects[i]);
+    delete objects[i];
+  }
+  delete world;
+  delete dispatcher;
+  DeleteCollisionThreadSupport(threadSupport);
+}
+
+void CoreScene_BenchmarkCollisions() {
+  const int threadCounts[] = { 0, 2, 4, 8 };
+  for (int c = 1000; c <= 4000; c *= 2) {
+    for (int t = 0; t < 4; ++t) {
+      BenchmarkCollisionThreads(c, threadCounts[t]);
+    }
+  }
+}
+
+#endif
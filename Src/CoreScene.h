@@ -5,18 +5,40 @@
 #include "CoreModel.h"
 #include "CoreVector4f.h"
 #include "CoreTexture.h"
+#include "SceneGraph.h"
+#include "DrawList.h"
+#include "GazeBroadphase.h"
+#include "CollisionThread.h"
+#include "bullet/BulletMultiThreaded/btThreadSupportInterface.h"
 #include "Kernel/OVR_Std.h"
 
 class CoreScene {
 public:
   OVR::Array<JS::Heap<JS::Value>> children;
+  OVR::Hash<int, CoreModel*> modelsById; // Every model in the scene, by id
+  SceneGraph graph;
+  DrawList drawList;
+  GazeBroadphase gazeBroadphase;
+  OVR::Array<CoreModel*> gazeActive; // Models that were hovered or touched last frame
 
   // Would it make sense to wrap these all in an object?
   btDefaultCollisionConfiguration* collisionConfiguration;
   btCollisionDispatcher* dispatcher;
   btBroadphaseInterface* overlappingPairCache;
   btSequentialImpulseConstraintSolver* solver;
+  // Collision objects always live in collisionWorld. It's only a full
+  // dynamicsWorld (the same object) when dynamics were configured on.
+  btCollisionWorld* collisionWorld;
   btDiscreteDynamicsWorld* dynamicsWorld;
+  // Narrowphase workers when collisionThreads > 0, otherwise NULL
+  btThreadSupportInterface* collisionThreadSupport;
+  int collisionThreads;
+  // Runs each frame's collision pass alongside the rest of the frame when
+  // configured, delivering its events a frame later. Otherwise NULL.
+  CollisionThread* collisionThread;
+
+  // Hand callbacks a new ev every frame, for scripts that keep it around
+  bool freshFrameEvents;
 
   OVR::GlGeometry globe;
   OVR::GlProgram cubeProgram;
@@ -29,14 +51,29 @@ public:
   CoreScene();
   ~CoreScene();
   bool RemoveModel(JSContext* cx, CoreModel* model);
+  void RegisterModel(JSContext* cx, CoreModel* model);
+  void UnregisterModel(JSContext* cx, CoreModel* model);
+  void UpdateGraph(JSContext* cx);
   void ComputeMatrices(JSContext* cx);
+  void ComputeWorldMatrices();
   void CallFrameCallbacks(JSContext* cx, JS::HandleValue ev);
   void CallGazeCallbacks(JSContext* cx, OVR::OvrGuiSys* guiSys, OVR::Vector3f* viewPos, OVR::Vector3f* viewFwd, const OVR::VrFrame& vrFrame, JS::HandleValue ev);
   void PerformCollisionDetection(JSContext* cx, double now, JS::HandleValue ev);
-  void DrawEyeView(JSContext* cx, OVR::OvrGuiSys* guiSys, const int eye, const OVR::Matrix4f& eyeViewMatrix, const OVR::Matrix4f& eyeProjectionMatrix, const OVR::Matrix4f& eyeViewProjection, ovrFrameParms& frameParms);
-  CoreModel* ModelById(JSContext* cx, int id);
+  bool ConfigureCollisions(JSContext* cx, bool dynamics, int threads, bool threaded);
+  void WaitForCollisions();
+  void RecordDrawList(JSContext* cx, OVR::OvrGuiSys* guiSys, const ViewFrustum& frustum);
+  void DrawEyeView(const int eye, const OVR::Matrix4f& eyeViewMatrix, const OVR::Matrix4f& eyeProjectionMatrix, const OVR::Matrix4f& eyeViewProjection, ovrFrameParms& frameParms);
+  CoreModel* ModelById(int id);
 private:
   double lastCollisionTick;
+  // Colliding model id pairs, packed (smaller id << 32 | larger id) and sorted
+  OVR::Array<uint64_t> collisionPairs;
+  OVR::Array<uint64_t> lastCollisionPairs;
+
+  void CreateCollisionWorld(bool dynamics, int threads);
+  void DestroyCollisionWorld();
+  void SyncCollisionObjects(JSContext* cx);
+  void DeliverCollisionEvents(JSContext* cx, JS::HandleValue ev);
 };
 
 CoreScene* SetupCoreScene(JSContext* cx, JS::RootedObject *global, JS::RootedObject *core, JS::RootedObject *env);
@@ -45,8 +82,13 @@ CoreScene* GetCoreScene(JS::HandleObject obj);
 void CoreScene_finalize(JSFreeOp *fop, JSObject *obj);
 void CoreScene_trace(JSTracer *tracer, JSObject *obj);
 
+#ifdef FLINT_BENCHMARK
+void CoreScene_BenchmarkCollisions();
+#endif
+
 bool CoreScene_add(JSContext* cx, unsigned argc, JS::Value *vp);
 bool CoreScene_remove(JSContext* cx, unsigned argc, JS::Value *vp);
+bool CoreScene_configure(JSContext* cx, unsigned argc, JS::Value *vp);
 bool CoreScene_setClearColor(JSContext* cx, unsigned argc, JS::Value *vp);
 bool Core_print(JSContext* cx, unsigned argc, JS::Value *vp); // TODO: Move this somewhere else
 
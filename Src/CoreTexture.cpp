@@ -211,6 +211,9 @@ static bool CoreTexture_get_path(JSContext* cx, unsigned argc, JS::Value *vp) {
   JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
   JS::RootedObject self(cx, &args.thisv().toObject());
   CoreTexture* item = GetCoreTexture(self);
+  if (item == NULL) {
+    return ReportWrongThis(cx, "Texture");
+  }
   JS::RootedValue val(cx, *item->path);
   args.rval().set(val);
   return true;
@@ -224,6 +227,9 @@ static bool CoreTexture_set_path(JSContext* cx, unsigned argc, JS::Value* vp) {
   }
   JS::RootedObject self(cx, &args.thisv().toObject());
   CoreTexture* item = GetCoreTexture(self);
+  if (item == NULL) {
+    return ReportWrongThis(cx, "Texture");
+  }
   JS::Heap<JS::Value>* oldPath = item->path;
   item->path = new JS::Heap<JS::Value>(args[0]);
   delete oldPath;
@@ -235,6 +241,9 @@ static bool CoreTexture_get_width(JSContext* cx, unsigned argc, JS::Value *vp) {
   JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
   JS::RootedObject self(cx, &args.thisv().toObject());
   CoreTexture* item = GetCoreTexture(self);
+  if (item == NULL) {
+    return ReportWrongThis(cx, "Texture");
+  }
   args.rval().setInt32(item->width);
   return true;
 }
@@ -247,6 +256,9 @@ static bool CoreTexture_set_width(JSContext* cx, unsigned argc, JS::Value* vp) {
   }
   JS::RootedObject self(cx, &args.thisv().toObject());
   CoreTexture* item = GetCoreTexture(self);
+  if (item == NULL) {
+    return ReportWrongThis(cx, "Texture");
+  }
   item->width = args[0].toInt32();
   item->Rebuild(cx);
   return true;
@@ -256,6 +268,9 @@ static bool CoreTexture_get_height(JSContext* cx, unsigned argc, JS::Value *vp)
   JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
   JS::RootedObject self(cx, &args.thisv().toObject());
   CoreTexture* item = GetCoreTexture(self);
+  if (item == NULL) {
+    return ReportWrongThis(cx, "Texture");
+  }
   args.rval().setInt32(item->height);
   return true;
 }
@@ -268,6 +283,9 @@ static bool CoreTexture_set_height(JSContext* cx, unsigned argc, JS::Value* vp)
   }
   JS::RootedObject self(cx, &args.thisv().toObject());
   CoreTexture* item = GetCoreTexture(self);
+  if (item == NULL) {
+    return ReportWrongThis(cx, "Texture");
+  }
   item->height = args[0].toInt32();
   item->Rebuild(cx);
   return true;
@@ -277,6 +295,9 @@ static bool CoreTexture_get_cube(JSContext* cx, unsigned argc, JS::Value *vp) {
   JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
   JS::RootedObject self(cx, &args.thisv().toObject());
   CoreTexture* item = GetCoreTexture(self);
+  if (item == NULL) {
+    return ReportWrongThis(cx, "Texture");
+  }
   args.rval().setBoolean(item->cube);
   return true;
 }
@@ -289,6 +310,9 @@ static bool CoreTexture_set_cube(JSContext* cx, unsigned argc, JS::Value* vp) {
   }
   JS::RootedObject self(cx, &args.thisv().toObject());
   CoreTexture* item = GetCoreTexture(self);
+  if (item == NULL) {
+    return ReportWrongThis(cx, "Texture");
+  }
   item->cube = args[0].toBoolean();
   item->Rebuild(cx);
   return true;
@@ -302,16 +326,19 @@ static JSPropertySpec CoreTexture_props[] = {
   JS_PS_END
 };
 
+static JS::PersistentRootedObject coreTextureProto;
+
 JSObject* NewCoreTexture(JSContext* cx, CoreTexture* tex) {
-  JS::RootedObject self(cx, JS_NewObject(cx, &coreTextureClass));
-  if (!JS_DefineProperties(cx, self, CoreTexture_props)) {
-    __android_log_print(ANDROID_LOG_ERROR, LOG_COMPONENT, "Could not define properties on Texture\n");
-  }
+  JS::RootedObject self(cx, JS_NewObjectWithGivenProto(cx, &coreTextureClass, coreTextureProto));
   JS_SetPrivate(self, (void *)tex);
   return self;
 }
 
 CoreTexture* GetCoreTexture(JS::HandleObject obj) {
+  // The prototype and objects of other classes have no payload for us
+  if (JS_GetClass(obj) != &coreTextureClass) {
+    return NULL;
+  }
   return (CoreTexture*)JS_GetPrivate(obj);
 }
 
@@ -398,11 +425,11 @@ void SetupCoreTexture(JSContext* cx, JS::RootedObject *global, JS::RootedObject
   JSObject *obj = JS_InitClass(
       cx,
       *core,
-      *global,
+      nullptr,
       &coreTextureClass,
       CoreTexture_constructor,
       1,
-      nullptr, /* Properties */
+      CoreTexture_props, /* Properties */
       nullptr, /* Methods */
       nullptr, /* Static Props */
       nullptr  /* Static Methods */);
@@ -410,6 +437,7 @@ void SetupCoreTexture(JSContext* cx, JS::RootedObject *global, JS::RootedObject
     __android_log_print(ANDROID_LOG_ERROR, LOG_COMPONENT, "Could not construct env.core.Texture class\n");
     return;
   }
+  coreTextureProto.init(cx, obj);
 }
 
 const JSClass* CoreTexture_class() {
@@ -1,4 +1,5 @@
 #include "CoreVector2f.h"
+#include "MathPool.h"
 
 
 static JSClass coreVector2fClass = {
@@ -18,6 +19,9 @@ static bool CoreVector2f_get_x(JSContext* cx, unsigned argc, JS::Value *vp) {
   JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
   JS::RootedObject self(cx, &args.thisv().toObject());
   OVR::Vector2f* item = GetVector2f(self);
+  if (item == NULL) {
+    return ReportWrongThis(cx, "Vector2f");
+  }
   args.rval().setNumber(item->x);
   return true;
 }
@@ -30,6 +34,9 @@ static bool CoreVector2f_set_x(JSContext* cx, unsigned argc, JS::Value* vp) {
   }
   JS::RootedObject self(cx, &args.thisv().toObject());
   OVR::Vector2f* item = GetVector2f(self);
+  if (item == NULL) {
+    return ReportWrongThis(cx, "Vector2f");
+  }
   item->x = args[0].toNumber();
   return true;
 }
@@ -38,6 +45,9 @@ static bool CoreVector2f_get_y(JSContext* cx, unsigned argc, JS::Value *vp) {
   JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
   JS::RootedObject self(cx, &args.thisv().toObject());
   OVR::Vector2f* item = GetVector2f(self);
+  if (item == NULL) {
+    return ReportWrongThis(cx, "Vector2f");
+  }
   args.rval().setNumber(item->y);
   return true;
 }
@@ -50,6 +60,9 @@ static bool CoreVector2f_set_y(JSContext* cx, unsigned argc, JS::Value* vp) { \
   }
   JS::RootedObject self(cx, &args.thisv().toObject());
   OVR::Vector2f* item = GetVector2f(self);
+  if (item == NULL) {
+    return ReportWrongThis(cx, "Vector2f");
+  }
   item->y = args[0].toNumber();
   return true;
 }
@@ -60,16 +73,19 @@ static JSPropertySpec CoreVector2f_props[] = {
   JS_PS_END
 };
 
-JSObject* NewCoreVector2f(JSContext* cx, OVR::Vector2f* vec) {
-  JS::RootedObject self(cx, JS_NewObject(cx, &coreVector2fClass));
-  if (!JS_DefineProperties(cx, self, CoreVector2f_props)) {
-    __android_log_print(ANDROID_LOG_ERROR, LOG_COMPONENT, "Could not define properties on Vector2f\n");
-  }
-  JS_SetPrivate(self, (void *)vec);
+static JS::PersistentRootedObject coreVector2fProto;
+
+JSObject* NewCoreVector2f(JSContext* cx, const OVR::Vector2f& vec) {
+  JS::RootedObject self(cx, JS_NewObjectWithGivenProto(cx, &coreVector2fClass, coreVector2fProto));
+  JS_SetPrivate(self, (void *)Vector2fPool.New(vec));
   return self;
 }
 
 OVR::Vector2f* GetVector2f(JS::HandleObject obj) {
+  // The prototype and objects of other classes have no payload for us
+  if (JS_GetClass(obj) != &coreVector2fClass) {
+    return NULL;
+  }
   return (OVR::Vector2f*)JS_GetPrivate(obj);
 }
 
@@ -99,7 +115,7 @@ bool CoreVector2f_constructor(JSContext* cx, unsigned argc, JS::Value *vp) {
   }
 
   // Go ahead and create our self object
-  JS::RootedObject self(cx, NewCoreVector2f(cx, new OVR::Vector2f(x, y)));
+  JS::RootedObject self(cx, NewCoreVector2f(cx, OVR::Vector2f(x, y)));
 
   // Return our self object
   args.rval().set(JS::ObjectOrNullValue(self));
@@ -109,18 +125,18 @@ bool CoreVector2f_constructor(JSContext* cx, unsigned argc, JS::Value *vp) {
 void CoreVector2f_finalize(JSFreeOp *fop, JSObject *obj) {
   OVR::Vector2f* vec = (OVR::Vector2f*)JS_GetPrivate(obj);
   JS_SetPrivate(obj, NULL);
-  delete vec;
+  Vector2fPool.Delete(vec);
 }
 
 void SetupCoreVector2f(JSContext* cx, JS::RootedObject *global, JS::RootedObject *core) {
   JSObject *obj = JS_InitClass(
       cx,
       *core,
-      *global,
+      nullptr,
       &coreVector2fClass,
       CoreVector2f_constructor,
       2,
-      nullptr, /* Properties */
+      CoreVector2f_props, /* Properties */
       nullptr, /* Methods */
       nullptr, /* Static Props */
       nullptr  /* Static Methods */);
@@ -128,6 +144,7 @@ void SetupCoreVector2f(JSContext* cx, JS::RootedObject *global, JS::RootedObject
     __android_log_print(ANDROID_LOG_ERROR, LOG_COMPONENT, "Could not construct env.core.Vector2f class\n");
     return;
   }
+  coreVector2fProto.init(cx, obj);
 }
 
 const JSClass* CoreVector2f_class() {
@@ -4,7 +4,7 @@
 #include "BaseInclude.h"
 
 void SetupCoreVector2f(JSContext* cx, JS::RootedObject *global, JS::RootedObject *core);
-JSObject* NewCoreVector2f(JSContext* cx, OVR::Vector2f* vec);
+JSObject* NewCoreVector2f(JSContext* cx, const OVR::Vector2f& vec);
 OVR::Vector2f* GetVector2f(JS::HandleObject obj);
 
 //
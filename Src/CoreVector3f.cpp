@@ -1,9 +1,10 @@
 #include "CoreVector3f.h"
+#include "MathPool.h"
 
 
 static JSClass coreVector3fClass = {
   "Vector3f",             /* name */
-  JSCLASS_HAS_PRIVATE,    /* flags */
+  JSCLASS_HAS_PRIVATE | JSCLASS_HAS_RESERVED_SLOTS(1), /* flags */
   NULL,
   NULL,
   NULL,
@@ -18,6 +19,9 @@ static bool CoreVector3f_get_x(JSContext* cx, unsigned argc, JS::Value *vp) {
   JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
   JS::RootedObject self(cx, &args.thisv().toObject());
   OVR::Vector3f* item = GetVector3f(self);
+  if (item == NULL) {
+    return ReportWrongThis(cx, "Vector3f");
+  }
   args.rval().setNumber(item->x);
   return true;
 }
@@ -30,7 +34,11 @@ static bool CoreVector3f_set_x(JSContext* cx, unsigned argc, JS::Value* vp) {
   }
   JS::RootedObject self(cx, &args.thisv().toObject());
   OVR::Vector3f* item = GetVector3f(self);
+  if (item == NULL) {
+    return ReportWrongThis(cx, "Vector3f");
+  }
   item->x = args[0].toNumber();
+  BumpChangeStamp(self);
   return true;
 }
 
@@ -38,6 +46,9 @@ static bool CoreVector3f_get_y(JSContext* cx, unsigned argc, JS::Value *vp) {
   JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
   JS::RootedObject self(cx, &args.thisv().toObject());
   OVR::Vector3f* item = GetVector3f(self);
+  if (item == NULL) {
+    return ReportWrongThis(cx, "Vector3f");
+  }
   args.rval().setNumber(item->y);
   return true;
 }
@@ -50,7 +61,11 @@ static bool CoreVector3f_set_y(JSContext* cx, unsigned argc, JS::Value* vp) {
   }
   JS::RootedObject self(cx, &args.thisv().toObject());
   OVR::Vector3f* item = GetVector3f(self);
+  if (item == NULL) {
+    return ReportWrongThis(cx, "Vector3f");
+  }
   item->y = args[0].toNumber();
+  BumpChangeStamp(self);
   return true;
 }
 
@@ -58,6 +73,9 @@ static bool CoreVector3f_get_z(JSContext* cx, unsigned argc, JS::Value *vp) {
   JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
   JS::RootedObject self(cx, &args.thisv().toObject());
   OVR::Vector3f* item = GetVector3f(self);
+  if (item == NULL) {
+    return ReportWrongThis(cx, "Vector3f");
+  }
   args.rval().setNumber(item->z);
   return true;
 }
@@ -70,7 +88,11 @@ static bool CoreVector3f_set_z(JSContext* cx, unsigned argc, JS::Value* vp) {
   }
   JS::RootedObject self(cx, &args.thisv().toObject());
   OVR::Vector3f* item = GetVector3f(self);
+  if (item == NULL) {
+    return ReportWrongThis(cx, "Vector3f");
+  }
   item->z = args[0].toNumber();
+  BumpChangeStamp(self);
   return true;
 }
 
@@ -81,24 +103,25 @@ static JSPropertySpec CoreVector3f_props[] = {
   JS_PS_END
 };
 
-JSObject* NewCoreVector3f(JSContext* cx, OVR::Vector3f* vec) {
-  JS::RootedObject self(cx, JS_NewObject(cx, &coreVector3fClass));
-  if (!JS_DefineProperties(cx, self, CoreVector3f_props)) {
-    __android_log_print(ANDROID_LOG_ERROR, LOG_COMPONENT, "Could not define properties on Vector3f\n");
-  }
-  if (!JS_DefineFunction(cx, self, "add", &CoreVector3f_add, 0, 0)) {
-    JS_ReportError(cx, "Could not create Vector3f.add function");
-    return NULL;
-  }
-  if (!JS_DefineFunction(cx, self, "multiply", &CoreVector3f_multiply, 0, 0)) {
-    JS_ReportError(cx, "Could not create Vector3f.multiply function");
-    return NULL;
-  }
-  JS_SetPrivate(self, (void *)vec);
+static JS::PersistentRootedObject coreVector3fProto;
+
+static JSFunctionSpec CoreVector3f_methods[] = {
+  JS_FN("add", CoreVector3f_add, 0, 0),
+  JS_FN("multiply", CoreVector3f_multiply, 0, 0),
+  JS_FS_END
+};
+
+JSObject* NewCoreVector3f(JSContext* cx, const OVR::Vector3f& vec) {
+  JS::RootedObject self(cx, JS_NewObjectWithGivenProto(cx, &coreVector3fClass, coreVector3fProto));
+  JS_SetPrivate(self, (void *)Vector3fPool.New(vec));
   return self;
 }
 
 OVR::Vector3f* GetVector3f(JS::HandleObject obj) {
+  // The prototype and objects of other classes have no payload for us
+  if (JS_GetClass(obj) != &coreVector3fClass) {
+    return NULL;
+  }
   return (OVR::Vector3f*)JS_GetPrivate(obj);
 }
 
@@ -132,7 +155,7 @@ bool CoreVector3f_constructor(JSContext* cx, unsigned argc, JS::Value *vp) {
   }
 
   // Go ahead and create our self object
-  JS::RootedObject self(cx, NewCoreVector3f(cx, new OVR::Vector3f(x, y, z)));
+  JS::RootedObject self(cx, NewCoreVector3f(cx, OVR::Vector3f(x, y, z)));
 
   // Return our self object
   args.rval().set(JS::ObjectOrNullValue(self));
@@ -142,7 +165,7 @@ bool CoreVector3f_constructor(JSContext* cx, unsigned argc, JS::Value *vp) {
 void CoreVector3f_finalize(JSFreeOp *fop, JSObject *obj) {
   OVR::Vector3f* vec = (OVR::Vector3f*)JS_GetPrivate(obj);
   JS_SetPrivate(obj, NULL);
-  delete vec;
+  Vector3fPool.Delete(vec);
 }
 
 bool CoreVector3f_add(JSContext* cx, unsigned argc, JS::Value *vp) {
@@ -165,10 +188,12 @@ bool CoreVector3f_add(JSContext* cx, unsigned argc, JS::Value *vp) {
 
   JS::RootedObject thisObj(cx, &args.thisv().toObject());
   OVR::Vector3f* vec = GetVector3f(thisObj);
+  if (vec == NULL) {
+    return ReportWrongThis(cx, "Vector3f");
+  }
 
   // Do the addition
-  OVR::Vector3f* res = new OVR::Vector3f(*vec + *otherVec);
-  JS::RootedObject result(cx, NewCoreVector3f(cx, res));
+  JS::RootedObject result(cx, NewCoreVector3f(cx, *vec + *otherVec));
 
   args.rval().set(JS::ObjectOrNullValue(result));
   return true;
@@ -184,8 +209,11 @@ bool CoreVector3f_multiply(JSContext* cx, unsigned argc, JS::Value *vp) {
 
   JS::RootedObject thisObj(cx, &args.thisv().toObject());
   OVR::Vector3f* vec = GetVector3f(thisObj);
+  if (vec == NULL) {
+    return ReportWrongThis(cx, "Vector3f");
+  }
 
-  OVR::Vector3f* res;
+  OVR::Vector3f res;
   if (args[0].isNumber()) {
     double d;
     if (!JS::ToNumber(cx, args[0], &d)) {
@@ -193,7 +221,7 @@ bool CoreVector3f_multiply(JSContext* cx, unsigned argc, JS::Value *vp) {
       return false;
     }
     // Do the multiplication
-    res = new OVR::Vector3f(*vec * (float)d);
+    res = *vec * (float)d;
   } else if (args[0].isObject()) {
     JS::RootedObject otherVecObj(cx, &args[0].toObject());
     OVR::Vector3f* otherVec = GetVector3f(otherVecObj);
@@ -202,7 +230,7 @@ bool CoreVector3f_multiply(JSContext* cx, unsigned argc, JS::Value *vp) {
       return false;
     }
     // Do the multiplication
-    res = new OVR::Vector3f(*vec * *otherVec);
+    res = *vec * *otherVec;
   } else {
     JS_ReportError(cx, "Expected a vector3f or number argument");
     return false;
@@ -217,18 +245,19 @@ void SetupCoreVector3f(JSContext* cx, JS::RootedObject *global, JS::RootedObject
   JSObject *obj = JS_InitClass(
       cx,
       *core,
-      *global,
+      nullptr,
       &coreVector3fClass,
       CoreVector3f_constructor,
       3,
-      nullptr, /* Properties */
-      nullptr, /* Methods */
+      CoreVector3f_props, /* Properties */
+      CoreVector3f_methods, /* Methods */
       nullptr, /* Static Props */
       nullptr  /* Static Methods */);
   if (!obj) {
     __android_log_print(ANDROID_LOG_ERROR, LOG_COMPONENT, "Could not construct env.core.Vector3f class\n");
     return;
   }
+  coreVector3fProto.init(cx, obj);
 }
 
 const JSClass* CoreVector3f_class() {
@@ -4,7 +4,7 @@
 #include "BaseInclude.h"
 
 void SetupCoreVector3f(JSContext* cx, JS::RootedObject *global, JS::RootedObject *core);
-JSObject* NewCoreVector3f(JSContext* cx, OVR::Vector3f* vec);
+JSObject* NewCoreVector3f(JSContext* cx, const OVR::Vector3f& vec);
 OVR::Vector3f* GetVector3f(JS::HandleObject obj);
 void CoreVector3f_finalize(JSFreeOp *fop, JSObject *obj);
 const JSClass* CoreVector3f_class();
@@ -1,4 +1,5 @@
 #include "CoreVector4f.h"
+#include "MathPool.h"
 
 
 static JSClass coreVector4fClass = {
@@ -18,6 +19,9 @@ static bool CoreVector4f_get_x(JSContext* cx, unsigned argc, JS::Value *vp) {
   JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
   JS::RootedObject self(cx, &args.thisv().toObject());
   OVR::Vector4f* item = GetVector4f(self);
+  if (item == NULL) {
+    return ReportWrongThis(cx, "Vector4f");
+  }
   args.rval().setNumber(item->x);
   return true;
 }
@@ -30,6 +34,9 @@ static bool CoreVector4f_set_x(JSContext* cx, unsigned argc, JS::Value* vp) {
   }
   JS::RootedObject self(cx, &args.thisv().toObject());
   OVR::Vector4f* item = GetVector4f(self);
+  if (item == NULL) {
+    return ReportWrongThis(cx, "Vector4f");
+  }
   item->x = args[0].toNumber();
   return true;
 }
@@ -38,6 +45,9 @@ static bool CoreVector4f_get_y(JSContext* cx, unsigned argc, JS::Value *vp) {
   JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
   JS::RootedObject self(cx, &args.thisv().toObject());
   OVR::Vector4f* item = GetVector4f(self);
+  if (item == NULL) {
+    return ReportWrongThis(cx, "Vector4f");
+  }
   args.rval().setNumber(item->y);
   return true;
 }
@@ -50,6 +60,9 @@ static bool CoreVector4f_set_y(JSContext* cx, unsigned argc, JS::Value* vp) {
   }
   JS::RootedObject self(cx, &args.thisv().toObject());
   OVR::Vector4f* item = GetVector4f(self);
+  if (item == NULL) {
+    return ReportWrongThis(cx, "Vector4f");
+  }
   item->y = args[0].toNumber();
   return true;
 }
@@ -58,6 +71,9 @@ static bool CoreVector4f_get_z(JSContext* cx, unsigned argc, JS::Value *vp) {
   JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
   JS::RootedObject self(cx, &args.thisv().toObject());
   OVR::Vector4f* item = GetVector4f(self);
+  if (item == NULL) {
+    return ReportWrongThis(cx, "Vector4f");
+  }
   args.rval().setNumber(item->z);
   return true;
 }
@@ -70,6 +86,9 @@ static bool CoreVector4f_set_z(JSContext* cx, unsigned argc, JS::Value* vp) {
   }
   JS::RootedObject self(cx, &args.thisv().toObject());
   OVR::Vector4f* item = GetVector4f(self);
+  if (item == NULL) {
+    return ReportWrongThis(cx, "Vector4f");
+  }
   item->z = args[0].toNumber();
   return true;
 }
@@ -78,6 +97,9 @@ static bool CoreVector4f_get_w(JSContext* cx, unsigned argc, JS::Value *vp) {
   JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
   JS::RootedObject self(cx, &args.thisv().toObject());
   OVR::Vector4f* item = GetVector4f(self);
+  if (item == NULL) {
+    return ReportWrongThis(cx, "Vector4f");
+  }
   args.rval().setNumber(item->w);
   return true;
 }
@@ -90,6 +112,9 @@ static bool CoreVector4f_set_w(JSContext* cx, unsigned argc, JS::Value* vp) {
   }
   JS::RootedObject self(cx, &args.thisv().toObject());
   OVR::Vector4f* item = GetVector4f(self);
+  if (item == NULL) {
+    return ReportWrongThis(cx, "Vector4f");
+  }
   item->w = args[0].toNumber();
   return true;
 }
@@ -102,16 +127,19 @@ static JSPropertySpec CoreVector4f_props[] = {
   JS_PS_END
 };
 
-JSObject* NewCoreVector4f(JSContext* cx, OVR::Vector4f* vec) {
-  JS::RootedObject self(cx, JS_NewObject(cx, &coreVector4fClass));
-  if (!JS_DefineProperties(cx, self, CoreVector4f_props)) {
-    __android_log_print(ANDROID_LOG_ERROR, LOG_COMPONENT, "Could not define properties on Vector4f\n");
-  }
-  JS_SetPrivate(self, (void *)vec);
+static JS::PersistentRootedObject coreVector4fProto;
+
+JSObject* NewCoreVector4f(JSContext* cx, const OVR::Vector4f& vec) {
+  JS::RootedObject self(cx, JS_NewObjectWithGivenProto(cx, &coreVector4fClass, coreVector4fProto));
+  JS_SetPrivate(self, (void *)Vector4fPool.New(vec));
   return self;
 }
 
 OVR::Vector4f* GetVector4f(JS::HandleObject obj) {
+  // The prototype and objects of other classes have no payload for us
+  if (JS_GetClass(obj) != &coreVector4fClass) {
+    return NULL;
+  }
   return (OVR::Vector4f*)JS_GetPrivate(obj);
 }
 
@@ -149,7 +177,7 @@ bool CoreVector4f_constructor(JSContext* cx, unsigned argc, JS::Value *vp) {
   }
 
   // Go ahead and create our self object
-  JS::RootedObject self(cx, NewCoreVector4f(cx, new OVR::Vector4f(x, y, z, w)));
+  JS::RootedObject self(cx, NewCoreVector4f(cx, OVR::Vector4f(x, y, z, w)));
 
   // Return our self object
   args.rval().set(JS::ObjectOrNullValue(self));
@@ -160,18 +188,18 @@ void CoreVector4f_finalize(JSFreeOp *fop, JSObject *obj) {
   OVR::Vector4f* vector4f = (OVR::Vector4f*)JS_GetPrivate(obj);
   JS_SetPrivate(obj, NULL);
   // TODO: Figure out what to do about ownership of this value and whether to free it
-  delete vector4f;
+  Vector4fPool.Delete(vector4f);
 }
 
 void SetupCoreVector4f(JSContext* cx, JS::RootedObject *global, JS::RootedObject *core) {
   JSObject *obj = JS_InitClass(
       cx,
       *core,
-      *global,
+      nullptr,
       &coreVector4fClass,
       CoreVector4f_constructor,
       4,
-      nullptr, /* Properties */
+      CoreVector4f_props, /* Properties */
       nullptr, /* Methods */
       nullptr, /* Static Props */
       nullptr  /* Static Methods */);
@@ -179,6 +207,7 @@ void SetupCoreVector4f(JSContext* cx, JS::RootedObject *global, JS::RootedObject
     __android_log_print(ANDROID_LOG_ERROR, LOG_COMPONENT, "Could not construct env.core.Vector4f class\n");
     return;
   }
+  coreVector4fProto.init(cx, obj);
 }
 
 const JSClass* CoreVector4f_class() {
@@ -4,7 +4,7 @@
 #include "BaseInclude.h"
 
 void SetupCoreVector4f(JSContext* cx, JS::RootedObject *global, JS::RootedObject *core);
-JSObject* NewCoreVector4f(JSContext* cx, OVR::Vector4f* vec);
+JSObject* NewCoreVector4f(JSContext* cx, const OVR::Vector4f& vec);
 OVR::Vector4f* GetVector4f(JS::HandleObject obj);
 void CoreVector4f_finalize(JSFreeOp *fop, JSObject *obj);
 const JSClass* CoreVector4f_class();
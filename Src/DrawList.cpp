@@ -0,0 +1,306 @@
+#include "DrawList.h"
+
+
+ViewFrustum::ViewFrustum(const OVR::Matrix4f& centerViewMatrix, float fovDegreesX, float fovDegreesY, float halfIpd) :
+  viewMatrix(centerViewMatrix),
+  widen(halfIpd) {
+  float halfX = OVR::DegreeToRad(fovDegreesX) * 0.5f;
+  float halfY = OVR::DegreeToRad(fovDegreesY) * 0.5f;
+  // The view looks down -Z, so a point is inside when dot(plane, p) <= 0
+  planes[0] = OVR::Vector3f(cosf(halfX), 0.0f, sinf(halfX));  // right
+  planes[1] = OVR::Vector3f(-cosf(halfX), 0.0f, sinf(halfX)); // left
+  planes[2] = OVR::Vector3f(0.0f, cosf(halfY), sinf(halfY));  // top
+  planes[3] = OVR::Vector3f(0.0f, -cosf(halfY), sinf(halfY)); // bottom
+}
+
+bool ViewFrustum::CullsSphere(const OVR::Vector3f& center, float radius) const {
+  if (radius < 0.0f) {
+    return true;
+  }
+  if (radius == FLT_MAX) {
+    return false;
+  }
+  OVR::Vector3f viewCenter = viewMatrix.Transform(center);
+  // Entirely behind the viewer
+  if (viewCenter.z > radius) {
+    return true;
+  }
+  for (int i = 0; i < 4; ++i) {
+    if (planes[i].Dot(viewCenter) > radius + widen) {
+      return true;
+    }
+  }
+  return false;
+}
+
+DrawList::DrawList(void) :
+  culledCount(0),
+  clearColor(0, 0, 0, 1),
+  hasBackground(false),
+  backgroundCube(false),
+  instanceBuffer(0),
+  instancesUploaded(false) {
+}
+
+DrawList::~DrawList(void) {
+  if (instanceBuffer != 0) {
+    glDeleteBuffers(1, &instanceBuffer);
+  }
+}
+
+void GlStateCache::Reset() {
+  // Nothing is known about the state the framework left behind
+  program = (GLuint)-1;
+  vertexArrayObject = (GLuint)-1;
+  activeUnit = -1;
+  for (int i = 0; i < MAX_TEXTURE_UNITS; ++i) {
+    textureTargets[i] = GL_TEXTURE_2D;
+    textures[i] = (GLuint)-1;
+  }
+}
+
+void GlStateCache::UseProgram(GLuint prog) {
+  if (program != prog) {
+    glUseProgram(prog);
+    program = prog;
+  }
+}
+
+void GlStateCache::BindVertexArray(GLuint vao) {
+  if (vertexArrayObject != vao) {
+    glBindVertexArray(vao);
+    vertexArrayObject = vao;
+  }
+}
+
+void GlStateCache::BindTexture(int unit, GLenum target, GLuint texture) {
+  if (unit < MAX_TEXTURE_UNITS && textureTargets[unit] == target && textures[unit] == texture) {
+    return;
+  }
+  if (activeUnit != unit) {
+    glActiveTexture(GL_TEXTURE0 + unit);
+    activeUnit = unit;
+  }
+  glBindTexture(target, texture);
+  if (unit < MAX_TEXTURE_UNITS) {
+    textureTargets[unit] = target;
+    textures[unit] = texture;
+  }
+}
+
+void GlStateCache::UnbindAll() {
+  for (int i = MAX_TEXTURE_UNITS - 1; i >= 0; --i) {
+    if (textures[i] != 0 && textures[i] != (GLuint)-1) {
+      glActiveTexture(GL_TEXTURE0 + i);
+      glBindTexture(textureTargets[i], 0);
+    }
+  }
+  glActiveTexture(GL_TEXTURE0);
+  glBindVertexArray(0);
+  glUseProgram(0);
+  Reset();
+}
+
+static bool SameDrawUniform(const DrawUniform& a, const DrawUniform& b) {
+  if (a.location != b.location || a.type != b.type) {
+    return false;
+  }
+  switch (a.type) {
+    case GL_FLOAT:
+      return a.floatValues[0] == b.floatValues[0];
+    case GL_FLOAT_VEC2:
+      return memcmp(a.floatValues, b.floatValues, sizeof(float) * 2) == 0;
+    case GL_FLOAT_VEC3:
+      return memcmp(a.floatValues, b.floatValues, sizeof(float) * 3) == 0;
+    case GL_FLOAT_VEC4:
+      return memcmp(a.floatValues, b.floatValues, sizeof(float) * 4) == 0;
+    case GL_FLOAT_MAT4:
+      return memcmp(a.floatValues, b.floatValues, sizeof(float) * 16) == 0;
+    default:
+      return memcmp(a.intValues, b.intValues, sizeof(a.intValues)) == 0;
+  }
+}
+
+// Hands out small sequential ids so each part of the sort key fits its bits
+template<class C>
+static uint64_t DenseId(OVR::Hash<C, int>& ids, const C& key) {
+  int* id = ids.Get(key);
+  if (id != NULL) {
+    return (uint64_t)*id;
+  }
+  int next = ids.GetSize();
+  ids.Add(key, next);
+  return (uint64_t)next;
+}
+
+void DrawList::Clear() {
+  items.Clear();
+  order.Clear();
+  batches.Clear();
+  instanceMatrices.Clear();
+  culledCount = 0;
+  textures.Clear();
+  uniforms.Clear();
+  hasBackground = false;
+}
+
+void DrawList::Sort(const OVR::Matrix4f& centerViewMatrix) {
+  programIds.Clear();
+  textureSetIds.Clear();
+  vertexArrayIds.Clear();
+
+  const float MAX_SORT_DEPTH = 1000.0f;
+  order.Resize(items.GetSizeI());
+  for (int i = 0; i < items.GetSizeI(); ++i) {
+    DrawItem& item = items[i];
+
+    // FNV-1a over the bound textures identifies the texture set
+    uint64_t textureHash = 14695981039346656037ULL;
+    for (int t = 0; t < item.textureCount; ++t) {
+      const DrawTexture& tex = textures[item.textureStart + t];
+      textureHash = (textureHash ^ tex.target) * 1099511628211ULL;
+      textureHash = (textureHash ^ tex.texture) * 1099511628211ULL;
+    }
+
+    // Front to back within a batch, so early depth rejection can do its job
+    float depth = -centerViewMatrix.Transform(item.worldMatrix.GetTranslation()).z;
+    depth = OVR::Alg::Clamp(depth, 0.0f, MAX_SORT_DEPTH);
+    uint64_t depthBits = (uint64_t)(depth / MAX_SORT_DEPTH * 65535.0f);
+
+    item.sortKey =
+      (OVR::Alg::Min(DenseId(programIds, item.program->program), (uint64_t)0xFFFF) << 48) |
+      (OVR::Alg::Min(DenseId(textureSetIds, textureHash), (uint64_t)0xFFFF) << 32) |
+      (OVR::Alg::Min(DenseId(vertexArrayIds, item.vertexArrayObject), (uint64_t)0xFFFF) << 16) |
+      depthBits;
+    order[i].key = item.sortKey;
+    order[i].index = i;
+  }
+  OVR::Alg::QuickSort(order);
+
+  // Collapse runs of draws that only differ by their model matrix
+  batches.Clear();
+  instanceMatrices.Clear();
+  int i = 0;
+  while (i < order.GetSizeI()) {
+    const DrawItem& first = items[order[i].index];
+    int end = i + 1;
+    if (first.instanceMatrixLocation >= 0) {
+      while (end < order.GetSizeI() && CanInstance(first, items[order[end].index])) {
+        ++end;
+      }
+    }
+
+    DrawBatch batch;
+    batch.first = i;
+    batch.count = end - i;
+    batch.instanceOffset = -1;
+    if (batch.count > 1) {
+      batch.instanceOffset = instanceMatrices.GetSizeI();
+      for (int n = i; n < end; ++n) {
+        instanceMatrices.PushBack(items[order[n].index].worldMatrix.Transposed());
+      }
+    }
+    batches.PushBack(batch);
+    i = end;
+  }
+  instancesUploaded = false;
+}
+
+bool DrawList::CanInstance(const DrawItem& a, const DrawItem& b) const {
+  if (a.program != b.program ||
+      a.vertexArrayObject != b.vertexArrayObject ||
+      a.indexCount != b.indexCount ||
+      a.textureCount != b.textureCount ||
+      a.uniformCount != b.uniformCount) {
+    return false;
+  }
+  for (int t = 0; t < a.textureCount; ++t) {
+    const DrawTexture& texA = textures[a.textureStart + t];
+    const DrawTexture& texB = textures[b.textureStart + t];
+    if (texA.target != texB.target || texA.texture != texB.texture) {
+      return false;
+    }
+  }
+  for (int u = 0; u < a.uniformCount; ++u) {
+    if (!SameDrawUniform(uniforms[a.uniformStart + u], uniforms[b.uniformStart + u])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void DrawList::Draw(const OVR::Matrix4f& eyeViewMatrix, const OVR::Matrix4f& eyeProjectionMatrix) {
+  // The instance matrices are the same for both eyes, so upload them once
+  if (!instancesUploaded && instanceMatrices.GetSizeI() > 0) {
+    if (instanceBuffer == 0) {
+      glGenBuffers(1, &instanceBuffer);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, instanceMatrices.GetSizeI() * sizeof(OVR::Matrix4f), instanceMatrices.GetDataPtr(), GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    instancesUploaded = true;
+  }
+
+  state.Reset();
+  for (int b = 0; b < batches.GetSizeI(); ++b) {
+    const DrawBatch& batch = batches[b];
+    const DrawItem& item = items[order[batch.first].index];
+    OVR::GlProgram* prog = item.program;
+
+    // Switch programs, and give each one the eye matrices once per eye
+    if (state.program != prog->program) {
+      state.UseProgram(prog->program);
+      glUniformMatrix4fv(prog->uView, 1, GL_TRUE, eyeViewMatrix.M[0]);
+      glUniformMatrix4fv(prog->uProjection, 1, GL_TRUE, eyeProjectionMatrix.M[0]);
+    }
+
+    // Bind textures
+    for (int t = 0; t < item.textureCount; ++t) {
+      const DrawTexture& tex = textures[item.textureStart + t];
+      state.BindTexture(t, tex.target, tex.texture);
+    }
+
+    // Now we bind our uniforms
+    for (int u = 0; u < item.uniformCount; ++u) {
+      ApplyDrawUniform(uniforms[item.uniformStart + u]);
+    }
+
+    // Bind the vertex array
+    state.BindVertexArray(item.vertexArrayObject);
+
+    GLint loc = item.instanceMatrixLocation;
+    if (batch.count == 1) {
+      glUniformMatrix4fv(prog->uModel, 1, GL_TRUE, item.worldMatrix.M[0]);
+      if (loc >= 0) {
+        // Instancing programs read the matrix from the attribute, so hand it
+        // over as a constant value, one column per location
+        const OVR::Matrix4f& m = item.worldMatrix;
+        for (int c = 0; c < 4; ++c) {
+          glVertexAttrib4f(loc + c, m.M[0][c], m.M[1][c], m.M[2][c], m.M[3][c]);
+        }
+      }
+      glDrawElements(GL_TRIANGLES, item.indexCount, item.indexType, NULL);
+    } else {
+      glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+      for (int c = 0; c < 4; ++c) {
+        size_t offset = batch.instanceOffset * sizeof(OVR::Matrix4f) + c * 4 * sizeof(float);
+        glEnableVertexAttribArray(loc + c);
+        glVertexAttribPointer(loc + c, 4, GL_FLOAT, GL_FALSE, sizeof(OVR::Matrix4f), (const GLvoid*)offset);
+        glVertexAttribDivisor(loc + c, 1);
+      }
+      glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+      glDrawElementsInstanced(GL_TRIANGLES, item.indexCount, item.indexType, NULL, batch.count);
+
+      // Leave the geometry's VAO the way we found it
+      for (int c = 0; c < 4; ++c) {
+        glVertexAttribDivisor(loc + c, 0);
+        glDisableVertexAttribArray(loc + c);
+      }
+    }
+  }
+
+  // Unbind once, at the end
+  state.UnbindAll();
+  OVR::GL_CheckErrors("DrawList - Draw");
+}
@@ -0,0 +1,107 @@
+#ifndef DRAW_LIST_H
+#define DRAW_LIST_H
+
+#include "BaseInclude.h"
+#include "CoreProgram.h"
+
+struct DrawTexture {
+  GLenum target;
+  GLuint texture;
+};
+
+// Everything needed to draw one model, resolved out of its JS values
+struct DrawItem {
+  uint64_t sortKey;
+  OVR::GlProgram* program;
+  GLint instanceMatrixLocation;
+  GLuint vertexArrayObject;
+  int indexCount;
+  GLenum indexType;
+  int textureStart;
+  int textureCount;
+  int uniformStart;
+  int uniformCount;
+  OVR::Matrix4f worldMatrix;
+};
+
+struct DrawSortEntry {
+  uint64_t key;
+  int index;
+  bool operator<(const DrawSortEntry& other) const {
+    return key < other.key || (key == other.key && index < other.index);
+  }
+};
+
+// A run of sorted draws that go out in one call. Runs of more than one item
+// are drawn instanced, reading their matrices from instanceOffset onwards.
+struct DrawBatch {
+  int first; // Into DrawList::order
+  int count;
+  int instanceOffset;
+};
+
+// What we last bound, so replaying the list can skip redundant GL calls
+struct GlStateCache {
+  const static int MAX_TEXTURE_UNITS = 8;
+  GLuint program;
+  GLuint vertexArrayObject;
+  int activeUnit;
+  GLenum textureTargets[MAX_TEXTURE_UNITS];
+  GLuint textures[MAX_TEXTURE_UNITS];
+
+  void Reset();
+  void UseProgram(GLuint prog);
+  void BindVertexArray(GLuint vao);
+  void BindTexture(int unit, GLenum target, GLuint texture);
+  void UnbindAll();
+};
+
+// A conservative stand-in for the union of both eye frusta: the center eye's
+// frustum with its side planes pushed out by half the IPD. There's no far
+// plane since the eye projections are infinite.
+struct ViewFrustum {
+  OVR::Matrix4f viewMatrix;
+  OVR::Vector3f planes[4]; // View space side plane normals, pointing out
+  float widen;
+
+  ViewFrustum(const OVR::Matrix4f& centerViewMatrix, float fovDegreesX, float fovDegreesY, float halfIpd);
+  bool CullsSphere(const OVR::Vector3f& center, float radius) const;
+};
+
+// The scene's models flattened into native draw calls. It gets recorded once
+// per frame, then replayed for each eye with only the view and projection
+// changing, so nothing touches the JS heap while rendering.
+class DrawList {
+public:
+  OVR::Array<DrawItem> items;
+  OVR::Array<DrawSortEntry> order; // Items sorted by program, textures, VAO, then depth
+  OVR::Array<DrawTexture> textures;
+  OVR::Array<DrawUniform> uniforms;
+  OVR::Array<DrawBatch> batches;
+  OVR::Array<OVR::Matrix4f> instanceMatrices; // Transposed, ready for GL
+  int culledCount; // Models with geometry left out by frustum culling
+
+  // Scene level state
+  OVR::Vector4f clearColor;
+  bool hasBackground;
+  bool backgroundCube;
+  DrawTexture background;
+
+  DrawList();
+  ~DrawList();
+  void Clear();
+  void Sort(const OVR::Matrix4f& centerViewMatrix);
+  void Draw(const OVR::Matrix4f& eyeViewMatrix, const OVR::Matrix4f& eyeProjectionMatrix);
+
+private:
+  GlStateCache state;
+  GLuint instanceBuffer;
+  bool instancesUploaded;
+  OVR::Hash<GLuint, int> programIds;
+  OVR::Hash<uint64_t, int> textureSetIds;
+  OVR::Hash<GLuint, int> vertexArrayIds;
+
+  bool CanInstance(const DrawItem& a, const DrawItem& b) const;
+};
+
+#endif
@@ -0,0 +1,65 @@
+#include "GazeBroadphase.h"
+#include "CoreModel.h"
+
+
+GazeBroadphase::GazeBroadphase(void) {
+}
+
+GazeBroadphase::~GazeBroadphase(void) {
+  tree.clear();
+}
+
+void GazeBroadphase::Update(CoreModel* model, const OVR::Bounds3f& bounds) {
+  const OVR::Vector3f& mins = bounds.GetMins();
+  const OVR::Vector3f& maxs = bounds.GetMaxs();
+  btDbvtVolume volume = btDbvtVolume::FromMM(btVector3(mins.x, mins.y, mins.z), btVector3(maxs.x, maxs.y, maxs.z));
+  if (model->gazeLeaf == NULL) {
+    model->gazeLeaf = tree.insert(volume, model);
+  } else {
+    tree.update(model->gazeLeaf, volume);
+  }
+}
+
+void GazeBroadphase::Remove(CoreModel* model) {
+  if (model->gazeLeaf != NULL) {
+    tree.remove(model->gazeLeaf);
+    model->gazeLeaf = NULL;
+  }
+}
+
+struct GazeCollector : btDbvt::ICollide {
+  OVR::Array<CoreModel*>* hits;
+  void Process(const btDbvtNode* leaf) {
+    hits->PushBack((CoreModel*)leaf->data);
+  }
+};
+
+// Slab test for where the ray enters the box
+static float RayEntry(const OVR::Vector3f& origin, const OVR::Vector3f& dir, const OVR::Bounds3f& bounds) {
+  float tMin = 0.0f;
+  for (int axis = 0; axis < 3; ++axis) {
+    if (dir[axis] == 0.0f) {
+      continue;
+    }
+    float t0 = (bounds.GetMins()[axis] - origin[axis]) / dir[axis];
+    float t1 = (bounds.GetMaxs()[axis] - origin[axis]) / dir[axis];
+    tMin = OVR::Alg::Max(tMin, OVR::Alg::Min(t0, t1));
+  }
+  return tMin;
+}
+
+void GazeBroadphase::Query(const OVR::Vector3f& origin, const OVR::Vector3f& dir, float maxDistance, OVR::Array<GazeCandidate>& out) {
+  OVR::Array<CoreModel*> hits;
+  GazeCollector collector;
+  collector.hits = &hits;
+  OVR::Vector3f end = origin + dir * maxDistance;
+  btDbvt::rayTest(tree.m_root, btVector3(origin.x, origin.y, origin.z), btVector3(end.x, end.y, end.z), collector);
+
+  for (int i = 0; i < hits.GetSizeI(); ++i) {
+    GazeCandidate candidate;
+    candidate.model = hits[i];
+    candidate.t = RayEntry(origin, dir, hits[i]->gazeBounds);
+    out.PushBack(candidate);
+  }
+  OVR::Alg::QuickSort(out);
+}
@@ -0,0 +1,32 @@
+#ifndef GAZE_BROADPHASE_H
+#define GAZE_BROADPHASE_H
+
+#include "BaseInclude.h"
+#include "bullet/BulletCollision/BroadphaseCollision/btDbvt.h"
+
+class CoreModel;
+
+struct GazeCandidate {
+  CoreModel* model;
+  float t; // Where the ray enters the model's bounds
+  bool operator<(const GazeCandidate& other) const {
+    return t < other.t;
+  }
+};
+
+// A dynamic AABB tree over the world bounds of every model that listens for
+// gaze or gesture events, so each frame only the models the gaze ray actually
+// passes near need a precise test
+class GazeBroadphase {
+public:
+  GazeBroadphase();
+  ~GazeBroadphase();
+  void Update(CoreModel* model, const OVR::Bounds3f& bounds);
+  void Remove(CoreModel* model);
+  // Models whose bounds the ray hits within maxDistance, nearest first
+  void Query(const OVR::Vector3f& origin, const OVR::Vector3f& dir, float maxDistance, OVR::Array<GazeCandidate>& out);
+private:
+  btDbvt tree;
+};
+
+#endif
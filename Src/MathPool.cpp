@@ -0,0 +1,47 @@
+#include "MathPool.h"
+
+
+MathPool<OVR::Vector2f> Vector2fPool("Vector2f");
+MathPool<OVR::Vector3f> Vector3fPool("Vector3f");
+MathPool<OVR::Vector4f> Vector4fPool("Vector4f");
+MathPool<OVR::Matrix4f> Matrix4fPool("Matrix4f");
+
+template<class T>
+static bool DefinePoolStats(JSContext* cx, JS::HandleObject stats, const MathPool<T>& pool) {
+  JS::RootedObject entry(cx, JS_NewPlainObject(cx));
+  if (!entry) {
+    return false;
+  }
+  JS::RootedValue live(cx, JS::NumberValue(pool.liveCount));
+  JS::RootedValue liveBytes(cx, JS::NumberValue((double)pool.LiveBytes()));
+  JS::RootedValue reservedBytes(cx, JS::NumberValue((double)pool.ReservedBytes()));
+  JS::RootedValue entryVal(cx, JS::ObjectValue(*entry));
+  return JS_SetProperty(cx, entry, "live", live) &&
+      JS_SetProperty(cx, entry, "liveBytes", liveBytes) &&
+      JS_SetProperty(cx, entry, "reservedBytes", reservedBytes) &&
+      JS_SetProperty(cx, stats, pool.name, entryVal);
+}
+
+// env.core.mathPoolStats() returns { Vector3f: { live, liveBytes, reservedBytes }, ... }
+bool Core_mathPoolStats(JSContext* cx, unsigned argc, JS::Value *vp) {
+  JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
+
+  JS::RootedObject stats(cx, JS_NewPlainObject(cx));
+  if (!stats ||
+      !DefinePoolStats(cx, stats, Vector2fPool) ||
+      !DefinePoolStats(cx, stats, Vector3fPool) ||
+      !DefinePoolStats(cx, stats, Vector4fPool) ||
+      !DefinePoolStats(cx, stats, Matrix4fPool)) {
+    JS_ReportError(cx, "Could not build math pool stats");
+    return false;
+  }
+
+  args.rval().set(JS::ObjectValue(*stats));
+  return true;
+}
+
+void SetupMathPools(JSContext* cx, JS::RootedObject *global, JS::RootedObject *core) {
+  if (!JS_DefineFunction(cx, *core, "mathPoolStats", &Core_mathPoolStats, 0, 0)) {
+    __android_log_print(ANDROID_LOG_ERROR, LOG_COMPONENT, "Could not create env.core.mathPoolStats function\n");
+  }
+}
@@ -0,0 +1,89 @@
+#ifndef MATH_POOL_H
+#define MATH_POOL_H
+
+#include "BaseInclude.h"
+#include <new>
+#include <type_traits>
+
+// Hands out fixed size payloads from slabs of SLAB_SIZE, so the vector and
+// matrix objects scripts churn through cost a freelist pop to create and a
+// push to finalize, instead of a trip through malloc. Slabs are only given
+// back when the pool goes away. Not thread safe: the math classes are only
+// created and finalized on the JS thread.
+template<class T>
+class MathPool {
+public:
+  const static int SLAB_SIZE = 256;
+
+  const char* name;
+  int liveCount;
+  int slabCount;
+
+  MathPool(const char* poolName) :
+    name(poolName),
+    liveCount(0),
+    slabCount(0),
+    freeList(NULL) {
+  }
+
+  ~MathPool() {
+    for (int i = 0; i < slabs.GetSizeI(); ++i) {
+      delete[] slabs[i];
+    }
+  }
+
+  T* New(const T& value) {
+    if (freeList == NULL) {
+      Grow();
+    }
+    Slot* slot = freeList;
+    freeList = slot->next;
+    ++liveCount;
+    return new (slot->storage) T(value);
+  }
+
+  void Delete(T* item) {
+    if (item == NULL) {
+      return;
+    }
+    item->~T();
+    Slot* slot = reinterpret_cast<Slot*>(item);
+    slot->next = freeList;
+    freeList = slot;
+    --liveCount;
+  }
+
+  size_t LiveBytes() const { return (size_t)liveCount * sizeof(T); }
+  size_t ReservedBytes() const { return (size_t)slabCount * SLAB_SIZE * sizeof(Slot); }
+
+private:
+  union Slot {
+    Slot* next;
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type storage[1];
+  };
+
+  OVR::Array<Slot*> slabs;
+  Slot* freeList;
+
+  void Grow() {
+    Slot* slab = new Slot[SLAB_SIZE];
+    // Thread the new slots onto the freelist in address order
+    for (int i = 0; i < SLAB_SIZE - 1; ++i) {
+      slab[i].next = &slab[i + 1];
+    }
+    slab[SLAB_SIZE - 1].next = freeList;
+    freeList = slab;
+    slabs.PushBack(slab);
+    ++slabCount;
+  }
+};
+
+extern MathPool<OVR::Vector2f> Vector2fPool;
+extern MathPool<OVR::Vector3f> Vector3fPool;
+extern MathPool<OVR::Vector4f> Vector4fPool;
+extern MathPool<OVR::Matrix4f> Matrix4fPool;
+
+void SetupMathPools(JSContext* cx, JS::RootedObject *global, JS::RootedObject *core);
+bool Core_mathPoolStats(JSContext* cx, unsigned argc, JS::Value *vp);
+
+#endif
@@ -11,7 +11,10 @@
 #include "CoreGeometry.h"
 #include "CoreModel.h"
 #include "CoreScene.h"
+#include "CoreFrameEvent.h"
+#include "MathPool.h"
 #include "CoreTexture.h"
+#include "TransformKernel.h"
 
 #define ERROR_DISPLAY_SECONDS 10
 
@@ -63,10 +66,13 @@ private:
   OVR::OvrGuiSys* GuiSys;
   OVR::ovrLocale* Locale;
   ovrMatrix4f CenterEyeViewMatrix;
+  float FovDegreesX;
+  float FovDegreesY;
   AAssetManager* AssetManager;
   JSRuntime* SpidermonkeyJSRuntime;
   JSContext* SpidermonkeyJSContext;
   mozilla::Maybe<JS::PersistentRootedObject> SpidermonkeyGlobal;
+  mozilla::Maybe<JS::PersistentRootedObject> FrameEvent;
   CoreScene* scene;
   mozilla::Maybe<JS::CompileOptions> CompileOptions;
   JS::Heap<JS::Value>* envValue;
@@ -80,7 +86,9 @@ static JSClass globalClass = {
 
 OvrApp::OvrApp(AAssetManager *assetManager) :
   GuiSys(OVR::OvrGuiSys::Create()),
-  Locale(NULL) {
+  Locale(NULL),
+  FovDegreesX(90.0f),
+  FovDegreesY(90.0f) {
   CenterEyeViewMatrix = ovrMatrix4f_CreateIdentity();
   AssetManager = assetManager;
 }
@@ -102,6 +110,11 @@ void OvrApp::OneTimeInit(const char* fromPackageName, const char* launchIntentJS
   GetLocale().GetString("@string/font_name", "efigs.fnt", fontName);
   GuiSys->Init(this->app, *SoundEffectPlayer, fontName.ToCStr(), &app->GetDebugLines());
 
+#ifdef FLINT_BENCHMARK
+  TransformKernel_Benchmark();
+  CoreScene_BenchmarkCollisions();
+#endif
+
   //app->SetShowFPS(true);
 
   // Initialize JS engine
@@ -138,6 +151,7 @@ void OvrApp::OneTimeInit(const char* fromPackageName, const char* launchIntentJS
     SetupCoreVector3f(cx, &global, &core);
     SetupCoreVector4f(cx, &global, &core);
     SetupCoreMatrix4f(cx, &global, &core);
+    SetupMathPools(cx, &global, &core);
     SetupCoreGeometry(cx, &global, &core);
     SetupCoreTexture(cx, &global, &core);
     SetupCoreModel(cx, &global, &core);
@@ -257,6 +271,7 @@ void OvrApp::LoadURL(OVR::String & url) {
 }
 
 void OvrApp::OneTimeShutdown() {
+  FrameEvent.reset();
   JS_DestroyContext(SpidermonkeyJSContext);
   JS_DestroyRuntime(SpidermonkeyJSRuntime);
   JS_ShutDown();
@@ -291,36 +306,39 @@ OVR::Matrix4f OvrApp::Frame(const OVR::VrFrame& vrFrame) {
     JS::RootedObject global(cx, SpidermonkeyGlobal.ref());
     JSAutoCompartment ac(cx, global);
 
-    OVR::Vector3f* viewPos = new OVR::Vector3f(OVR::GetViewMatrixPosition(CenterEyeViewMatrix));
-    OVR::Vector3f* viewFwd = new OVR::Vector3f(OVR::GetViewMatrixForward(CenterEyeViewMatrix));
+    OVR::Vector3f viewPos = OVR::GetViewMatrixPosition(CenterEyeViewMatrix);
+    OVR::Vector3f viewFwd = OVR::GetViewMatrixForward(CenterEyeViewMatrix);
+    double now = vrapi_GetTimeInSeconds();
 
-    // Build the ev
-    JS::RootedObject ev(cx, JS_NewObject(cx, nullptr));
-    JS::RootedValue viewPosVal(cx, JS::ObjectOrNullValue(NewCoreVector3f(cx, viewPos)));
-    if (!JS_SetProperty(cx, ev, "viewPos", viewPosVal)) {
-      __android_log_print(ANDROID_LOG_ERROR, LOG_COMPONENT, "Could not set ev.viewPos\n");
-      JS_ReportError(cx, "Could not set ev.viewPos");
-      return CenterEyeViewMatrix;
-    }
-    JS::RootedValue viewFwdVal(cx, JS::ObjectOrNullValue(NewCoreVector3f(cx, viewFwd)));
-    if (!JS_SetProperty(cx, ev, "viewFwd", viewFwdVal)) {
-      __android_log_print(ANDROID_LOG_ERROR, LOG_COMPONENT, "Could not set ev.viewFwd\n");
-      JS_ReportError(cx, "Could not set ev.viewFwd");
-      return CenterEyeViewMatrix;
+    // Fill in the ev, reusing the same one every frame unless the scene asked
+    // for a fresh one that scripts can hold on to
+    JS::RootedObject ev(cx);
+    if (scene->freshFrameEvents) {
+      ev = NewCoreFrameEvent(cx);
+    } else {
+      if (FrameEvent.isNothing()) {
+        FrameEvent.emplace(cx, NewCoreFrameEvent(cx));
+      }
+      ev = FrameEvent.ref();
     }
-    double now = vrapi_GetTimeInSeconds();
-    JS::RootedValue nowVal(cx, JS::NumberValue(now));
-    if (!JS_SetProperty(cx, ev, "now", nowVal)) {
-      __android_log_print(ANDROID_LOG_ERROR, LOG_COMPONENT, "Could not set ev.now\n");
-      JS_ReportError(cx, "Could not set ev.now");
+    if (!ev) {
+      FrameEvent.reset();
+      __android_log_print(ANDROID_LOG_ERROR, LOG_COMPONENT, "Could not create ev\n");
+      JS_ReportError(cx, "Could not create ev");
       return CenterEyeViewMatrix;
     }
+    UpdateCoreFrameEvent(cx, ev, viewPos, viewFwd, now);
     JS::RootedValue evValue(cx, JS::ObjectOrNullValue(ev));
 
     scene->ComputeMatrices(cx);
     scene->CallFrameCallbacks(cx, evValue);
-    scene->CallGazeCallbacks(cx, GuiSys, viewPos, viewFwd, vrFrame, evValue);
+    scene->CallGazeCallbacks(cx, GuiSys, &viewPos, &viewFwd, vrFrame, evValue);
     scene->PerformCollisionDetection(cx, now, evValue);
+
+    // Record one culled draw list for both eyes to replay, culling against both
+    // eyes at once with the fov from the last eye we drew
+    ViewFrustum frustum(CenterEyeViewMatrix, FovDegreesX, FovDegreesY, app->GetHeadModelParms().InterpupillaryDistance * 0.5f);
+    scene->RecordDrawList(cx, GuiSys, frustum);
   }
 
   // Update GUI systems last, but before rendering anything.
@@ -330,17 +348,14 @@ OVR::Matrix4f OvrApp::Frame(const OVR::VrFrame& vrFrame) {
 }
 
 OVR::Matrix4f OvrApp::DrawEyeView(const int eye, const float fovDegreesX, const float fovDegreesY, ovrFrameParms& frameParms) {
+  FovDegreesX = fovDegreesX;
+  FovDegreesY = fovDegreesY;
   const OVR::Matrix4f eyeViewMatrix = vrapi_GetEyeViewMatrix(&app->GetHeadModelParms(), &CenterEyeViewMatrix, eye);
   const OVR::Matrix4f eyeProjectionMatrix = ovrMatrix4f_CreateProjectionFov(fovDegreesX, fovDegreesY, 0.0f, 0.0f, VRAPI_ZNEAR, 0.0f);
   const OVR::Matrix4f eyeViewProjection = eyeProjectionMatrix * eyeViewMatrix;
 
-  // Call our scene's DrawEyeView
-  JSContext* cx = SpidermonkeyJSContext;
-  JS::RootedObject global(cx, SpidermonkeyGlobal.ref());
-  {
-    JSAutoCompartment ac(cx, global);
-    scene->DrawEyeView(cx, GuiSys, eye, eyeViewMatrix, eyeProjectionMatrix, eyeViewProjection, frameParms);
-  }
+  // Replay the draw list recorded in Frame
+  scene->DrawEyeView(eye, eyeViewMatrix, eyeProjectionMatrix, eyeViewProjection, frameParms);
 
   GuiSys->RenderEyeView( CenterEyeViewMatrix, eyeViewMatrix, eyeProjectionMatrix );
 
@@ -171,4 +171,76 @@ OVR::VertexAttribs* ParseVertexAttribs(JSContext* cx, JS::HandleValue val) {
   }
 
   return attribs;
-}
\ No newline at end of file
+}
+
+static int VertexAttributeComponents(int attribute) {
+  switch (attribute) {
+  case VERTEX_POSITION:
+  case VERTEX_NORMAL:
+  case VERTEX_TANGENT:
+  case VERTEX_BINORMAL:
+    return 3;
+  case VERTEX_COLOR:
+  case VERTEX_JOINT_WEIGHTS:
+    return 4;
+  case VERTEX_UV0:
+  case VERTEX_UV1:
+    return 2;
+  default:
+    // Joint indices are integers, so they can't ride along in float data
+    return 0;
+  }
+}
+
+int VertexLayout::Find(int attribute) const {
+  for (int i = 0; i < attributeCount; ++i) {
+    if (attributes[i] == attribute) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+bool ParseVertexLayout(JSContext* cx, JS::HandleValue val, VertexLayout* layout) {
+  bool isArray;
+  if (!val.isObject() || !JS_IsArrayObject(cx, val, &isArray) || !isArray) {
+    JS_ReportError(cx, "Expected layout to be an array of vertex constants");
+    return false;
+  }
+  JS::RootedObject layoutObj(cx, &val.toObject());
+  uint32_t length;
+  if (!JS_GetArrayLength(cx, layoutObj, &length)) {
+    JS_ReportError(cx, "Couldn't get layout array length");
+    return false;
+  }
+  if (length == 0 || length > MAX_LAYOUT_ATTRIBUTES) {
+    JS_ReportError(cx, "Expected between 1 and %d layout entries, got %d", MAX_LAYOUT_ATTRIBUTES, length);
+    return false;
+  }
+
+  layout->attributeCount = 0;
+  layout->stride = 0;
+  JS::RootedValue entry(cx);
+  for (uint32_t i = 0; i < length; ++i) {
+    if (!JS_GetElement(cx, layoutObj, i, &entry)) {
+      JS_ReportError(cx, "Couldn't get layout entry %d", i);
+      return false;
+    }
+    int attribute = entry.isInt32() ? entry.toInt32() : -1;
+    int components = VertexAttributeComponents(attribute);
+    if (components == 0) {
+      JS_ReportError(cx, "Unsupported vertex constant in layout position %d", i);
+      return false;
+    }
+    if (layout->Find(attribute) != -1) {
+      JS_ReportError(cx, "Vertex constant repeated in layout position %d", i);
+      return false;
+    }
+    int n = layout->attributeCount++;
+    layout->attributes[n] = attribute;
+    layout->components[n] = components;
+    layout->offsets[n] = layout->stride;
+    layout->stride += components;
+  }
+  return true;
+}
@@ -8,6 +8,22 @@
 
 OVR::VertexAttribs* ParseVertexAttribs(JSContext* cx, JS::HandleValue val);
 
+const static int MAX_LAYOUT_ATTRIBUTES = 9;
+
+// Where each attribute lives in one interleaved vertex of floats, built from a
+// layout array of VERTEX_* constants in the order they appear in the data
+struct VertexLayout {
+  int attributeCount;
+  int attributes[MAX_LAYOUT_ATTRIBUTES]; // VERTEX_* constants
+  int components[MAX_LAYOUT_ATTRIBUTES];
+  int offsets[MAX_LAYOUT_ATTRIBUTES]; // In floats from the start of the vertex
+  int stride; // Floats per vertex
+
+  int Find(int attribute) const;
+};
+
+bool ParseVertexLayout(JSContext* cx, JS::HandleValue val, VertexLayout* layout);
+
 #endif
 
 
@@ -0,0 +1,144 @@
+#include "SceneGraph.h"
+#include "CoreModel.h"
+
+
+SceneGraph::SceneGraph(void) :
+  boundsValid(false),
+  dirty(true) {
+}
+
+void SceneGraph::MarkDirty() {
+  dirty = true;
+}
+
+bool SceneGraph::IsDirty() const {
+  return dirty;
+}
+
+void SceneGraph::Rebuild(JSContext* cx, OVR::Array<JS::Heap<JS::Value>>& roots) {
+  // Forget the old indices so anything that was removed can't match a stale slot
+  for (int i = 0; i < nodes.GetSizeI(); ++i) {
+    nodes[i]->graphIndex = -1;
+  }
+
+  nodes.Clear();
+  parents.Clear();
+  subtreeEnds.Clear();
+  detached.Clear();
+  worldChanged.Clear();
+
+  for (int i = 0; i < roots.GetSizeI(); ++i) {
+    JS::RootedObject rootObj(cx, &roots[i].toObject());
+    Append(cx, GetCoreModel(rootObj), -1);
+  }
+
+  int count = nodes.GetSizeI();
+  transforms.Resize(count);
+  localMatrices.Resize(count);
+  worldMatrices.Resize(count);
+  subtreeSpheres.Resize(count);
+  subtreeDrawables.Resize(count);
+  boundsValid = false;
+  composeIndices.Reserve(count);
+  worldIndices.Reserve(count);
+
+  dirty = false;
+}
+
+void SceneGraph::Append(JSContext* cx, CoreModel* model, int parent) {
+  int idx = nodes.GetSizeI();
+  model->graphIndex = idx;
+  // The node may have a new parent, so its world matrix has to be recomputed
+  model->transformDirty = true;
+  nodes.PushBack(model);
+  parents.PushBack(parent);
+  subtreeEnds.PushBack(idx + 1);
+  detached.PushBack(false);
+  worldChanged.PushBack(true);
+
+  for (int i = 0; i < model->children.GetSizeI(); ++i) {
+    JS::RootedObject childObj(cx, &model->children[i].toObject());
+    Append(cx, GetCoreModel(childObj), idx);
+  }
+
+  subtreeEnds[idx] = nodes.GetSizeI();
+}
+
+void SceneGraph::Detach(CoreModel* model) {
+  // Passes already in flight keep walking the old arrays, so flag the whole
+  // subtree to be skipped until the next rebuild drops it for real
+  int idx = model->graphIndex;
+  if (idx < 0 || idx >= nodes.GetSizeI() || nodes[idx] != model) {
+    return;
+  }
+  for (int i = idx; i < subtreeEnds[idx]; ++i) {
+    detached[i] = true;
+  }
+  dirty = true;
+}
+
+// Smallest sphere around both, where a negative radius is empty and FLT_MAX
+// is unbounded
+static OVR::Vector4f MergeSpheres(const OVR::Vector4f& a, const OVR::Vector4f& b) {
+  if (b.w < 0.0f || a.w == FLT_MAX) {
+    return a;
+  }
+  if (a.w < 0.0f || b.w == FLT_MAX) {
+    return b;
+  }
+  OVR::Vector3f ca(a.x, a.y, a.z);
+  OVR::Vector3f cb(b.x, b.y, b.z);
+  OVR::Vector3f delta = cb - ca;
+  float dist = delta.Length();
+  if (dist + b.w <= a.w) {
+    return a;
+  }
+  if (dist + a.w <= b.w) {
+    return b;
+  }
+  float radius = (dist + a.w + b.w) * 0.5f;
+  OVR::Vector3f center = ca + delta * ((radius - a.w) / dist);
+  return OVR::Vector4f(center.x, center.y, center.z, radius);
+}
+
+void SceneGraph::ComputeSubtreeBounds() {
+  for (int i = 0; i < nodes.GetSizeI(); ++i) {
+    CoreModel* node = nodes[i];
+    if (detached[i]) {
+      subtreeSpheres[i] = OVR::Vector4f(0, 0, 0, -1.0f);
+      subtreeDrawables[i] = 0;
+    } else {
+      subtreeSpheres[i] = OVR::Vector4f(node->worldCenter.x, node->worldCenter.y, node->worldCenter.z, node->worldRadius);
+      subtreeDrawables[i] = node->boundsGeometry != NULL ? 1 : 0;
+    }
+  }
+
+  // Children come after their parents, so walking backwards finishes every
+  // subtree before it gets folded into its parent
+  for (int i = nodes.GetSizeI() - 1; i >= 0; --i) {
+    int parent = parents[i];
+    if (parent != -1) {
+      subtreeSpheres[parent] = MergeSpheres(subtreeSpheres[parent], subtreeSpheres[i]);
+      subtreeDrawables[parent] += subtreeDrawables[i];
+    }
+  }
+  boundsValid = true;
+}
+
+bool SceneGraph::IsLive(int idx) const {
+  return !detached[idx];
+}
+
+int SceneGraph::GetSizeI() const {
+  return nodes.GetSizeI();
+}
+
+void SceneGraph::Trace(JSTracer* tracer) {
+  // Keep every node we hold a raw pointer to alive until the next rebuild, even
+  // if a callback removed it from the tree part way through a pass
+  for (int i = 0; i < nodes.GetSizeI(); ++i) {
+    char buffer[50];
+    sprintf(buffer, "node%d", i);
+    TraceHeap(tracer, nodes[i]->selfVal, "graph", buffer);
+  }
+}
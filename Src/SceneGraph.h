@@ -0,0 +1,47 @@
+#ifndef SCENE_GRAPH_H
+#define SCENE_GRAPH_H
+
+#include "BaseInclude.h"
+#include "TransformKernel.h"
+
+class CoreModel;
+
+// A flattened copy of the scene's model tree, stored parent-before-child so
+// the per-frame passes can walk it linearly. The JS children arrays are still
+// the source of truth; this just gets rebuilt from them whenever they change.
+class SceneGraph {
+public:
+  OVR::Array<CoreModel*> nodes;
+  OVR::Array<int> parents;     // Index of each node's parent, or -1 for roots
+  OVR::Array<int> subtreeEnds; // One past the index of each node's last descendant
+  OVR::Array<bool> detached;   // Removed from the scene since the last rebuild
+  OVR::Array<bool> worldChanged; // World matrix was recomputed this frame
+
+  // Per-node transform inputs and outputs for the batched matrix kernels
+  TransformSoA transforms;
+  OVR::Array<OVR::Matrix4f> localMatrices;
+  OVR::Array<OVR::Matrix4f> worldMatrices;
+  OVR::Array<int> composeIndices; // Nodes whose own transform changed this frame
+  OVR::Array<int> worldIndices;   // Nodes whose world matrix needs recomputing
+
+  // Bounding sphere (xyz center, w radius) around each node and everything
+  // below it, plus how many of those nodes have geometry to draw
+  OVR::Array<OVR::Vector4f> subtreeSpheres;
+  OVR::Array<int> subtreeDrawables;
+  bool boundsValid; // Cleared by rebuilds until the bounds are recomputed
+
+  SceneGraph();
+  void MarkDirty();
+  bool IsDirty() const;
+  void Rebuild(JSContext* cx, OVR::Array<JS::Heap<JS::Value>>& roots);
+  void Detach(CoreModel* model);
+  void ComputeSubtreeBounds();
+  bool IsLive(int idx) const;
+  int GetSizeI() const;
+  void Trace(JSTracer* tracer);
+private:
+  bool dirty;
+  void Append(JSContext* cx, CoreModel* model, int parent);
+};
+
+#endif
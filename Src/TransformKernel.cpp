@@ -0,0 +1,405 @@
+#include "TransformKernel.h"
+
+#if defined(TRANSFORM_KERNEL_NEON)
+#include <arm_neon.h>
+#elif defined(TRANSFORM_KERNEL_SSE)
+#include <xmmintrin.h>
+#endif
+
+
+void TransformSoA::Resize(int count) {
+  posX.Resize(count);
+  posY.Resize(count);
+  posZ.Resize(count);
+  rotX.Resize(count);
+  rotY.Resize(count);
+  rotZ.Resize(count);
+  sclX.Resize(count);
+  sclY.Resize(count);
+  sclZ.Resize(count);
+  base.Resize(count);
+}
+
+// Every variant sums each output element as ((a0*b0 + a1*b1) + a2*b2) + a3*b3
+// with separate multiplies and adds, so they round the same way. The module is
+// built with -ffp-contract=off to keep the compiler from fusing the scalar one.
+// ARMv7 NEON flushes denormals to zero where VFP doesn't, so results agree with
+// the scalar kernel up to that flush rather than bit for bit.
+//
+// The batched paths run four transforms side by side, one per SIMD lane. Lane4
+// wraps the handful of operations they need.
+
+#if defined(TRANSFORM_KERNEL_NEON)
+
+typedef float32x4_t Lane4;
+
+static inline Lane4 Lane4Load(const float* p) { return vld1q_f32(p); }
+static inline void Lane4Store(float* p, Lane4 v) { vst1q_f32(p, v); }
+static inline Lane4 Lane4Splat(float f) { return vdupq_n_f32(f); }
+static inline Lane4 Lane4Add(Lane4 a, Lane4 b) { return vaddq_f32(a, b); }
+static inline Lane4 Lane4Sub(Lane4 a, Lane4 b) { return vsubq_f32(a, b); }
+static inline Lane4 Lane4Mul(Lane4 a, Lane4 b) { return vmulq_f32(a, b); }
+
+static inline void Lane4Transpose(Lane4& r0, Lane4& r1, Lane4& r2, Lane4& r3) {
+  float32x4x2_t t01 = vtrnq_f32(r0, r1);
+  float32x4x2_t t23 = vtrnq_f32(r2, r3);
+  r0 = vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0]));
+  r1 = vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1]));
+  r2 = vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0]));
+  r3 = vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1]));
+}
+
+const char* TransformKernel_Name() {
+  return "neon";
+}
+
+void TransformKernel_Multiply(const OVR::Matrix4f& a, const OVR::Matrix4f& b, OVR::Matrix4f& out) {
+  float32x4_t b0 = vld1q_f32(b.M[0]);
+  float32x4_t b1 = vld1q_f32(b.M[1]);
+  float32x4_t b2 = vld1q_f32(b.M[2]);
+  float32x4_t b3 = vld1q_f32(b.M[3]);
+  for (int r = 0; r < 4; ++r) {
+    float32x4_t row = vmulq_n_f32(b0, a.M[r][0]);
+    row = vaddq_f32(row, vmulq_n_f32(b1, a.M[r][1]));
+    row = vaddq_f32(row, vmulq_n_f32(b2, a.M[r][2]));
+    row = vaddq_f32(row, vmulq_n_f32(b3, a.M[r][3]));
+    vst1q_f32(out.M[r], row);
+  }
+}
+
+#elif defined(TRANSFORM_KERNEL_SSE)
+
+typedef __m128 Lane4;
+
+static inline Lane4 Lane4Load(const float* p) { return _mm_loadu_ps(p); }
+static inline void Lane4Store(float* p, Lane4 v) { _mm_storeu_ps(p, v); }
+static inline Lane4 Lane4Splat(float f) { return _mm_set1_ps(f); }
+static inline Lane4 Lane4Add(Lane4 a, Lane4 b) { return _mm_add_ps(a, b); }
+static inline Lane4 Lane4Sub(Lane4 a, Lane4 b) { return _mm_sub_ps(a, b); }
+static inline Lane4 Lane4Mul(Lane4 a, Lane4 b) { return _mm_mul_ps(a, b); }
+
+static inline void Lane4Transpose(Lane4& r0, Lane4& r1, Lane4& r2, Lane4& r3) {
+  _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+}
+
+const char* TransformKernel_Name() {
+  return "sse";
+}
+
+void TransformKernel_Multiply(const OVR::Matrix4f& a, const OVR::Matrix4f& b, OVR::Matrix4f& out) {
+  __m128 b0 = _mm_loadu_ps(b.M[0]);
+  __m128 b1 = _mm_loadu_ps(b.M[1]);
+  __m128 b2 = _mm_loadu_ps(b.M[2]);
+  __m128 b3 = _mm_loadu_ps(b.M[3]);
+  for (int r = 0; r < 4; ++r) {
+    __m128 row = _mm_mul_ps(b0, _mm_set1_ps(a.M[r][0]));
+    row = _mm_add_ps(row, _mm_mul_ps(b1, _mm_set1_ps(a.M[r][1])));
+    row = _mm_add_ps(row, _mm_mul_ps(b2, _mm_set1_ps(a.M[r][2])));
+    row = _mm_add_ps(row, _mm_mul_ps(b3, _mm_set1_ps(a.M[r][3])));
+    _mm_storeu_ps(out.M[r], row);
+  }
+}
+
+#else
+
+struct Lane4 {
+  float v[4];
+};
+
+static inline Lane4 Lane4Load(const float* p) {
+  Lane4 r;
+  memcpy(r.v, p, sizeof(r.v));
+  return r;
+}
+static inline void Lane4Store(float* p, const Lane4& v) { memcpy(p, v.v, sizeof(v.v)); }
+static inline Lane4 Lane4Splat(float f) {
+  Lane4 r = {{ f, f, f, f }};
+  return r;
+}
+static inline Lane4 Lane4Add(const Lane4& a, const Lane4& b) {
+  Lane4 r = {{ a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3] }};
+  return r;
+}
+static inline Lane4 Lane4Sub(const Lane4& a, const Lane4& b) {
+  Lane4 r = {{ a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3] }};
+  return r;
+}
+static inline Lane4 Lane4Mul(const Lane4& a, const Lane4& b) {
+  Lane4 r = {{ a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3] }};
+  return r;
+}
+
+static inline void Lane4Transpose(Lane4& r0, Lane4& r1, Lane4& r2, Lane4& r3) {
+  Lane4* rows[4] = { &r0, &r1, &r2, &r3 };
+  for (int i = 0; i < 4; ++i) {
+    for (int j = i + 1; j < 4; ++j) {
+      float t = rows[i]->v[j];
+      rows[i]->v[j] = rows[j]->v[i];
+      rows[j]->v[i] = t;
+    }
+  }
+}
+
+const char* TransformKernel_Name() {
+  return "scalar";
+}
+
+void TransformKernel_Multiply(const OVR::Matrix4f& a, const OVR::Matrix4f& b, OVR::Matrix4f& out) {
+  // Compute into a temporary so out may alias a or b
+  float res[4][4];
+  for (int r = 0; r < 4; ++r) {
+    for (int c = 0; c < 4; ++c) {
+      float sum = a.M[r][0] * b.M[0][c];
+      sum = sum + a.M[r][1] * b.M[1][c];
+      sum = sum + a.M[r][2] * b.M[2][c];
+      sum = sum + a.M[r][3] * b.M[3][c];
+      res[r][c] = sum;
+    }
+  }
+  memcpy(out.M, res, sizeof(res));
+}
+
+#endif
+
+// Lane j of the result holds element [r][c] of matrix j, for four matrices
+static void LoadLanes(const OVR::Matrix4f* const* m, Lane4 lanes[4][4]) {
+  for (int r = 0; r < 4; ++r) {
+    lanes[r][0] = Lane4Load(m[0]->M[r]);
+    lanes[r][1] = Lane4Load(m[1]->M[r]);
+    lanes[r][2] = Lane4Load(m[2]->M[r]);
+    lanes[r][3] = Lane4Load(m[3]->M[r]);
+    Lane4Transpose(lanes[r][0], lanes[r][1], lanes[r][2], lanes[r][3]);
+  }
+}
+
+// out[j] = a[j] * b[j] with both sides already spread across lanes. Everything
+// is computed before the first store, so out may alias the inputs.
+static void MultiplyLanes(const Lane4 a[4][4], const Lane4 b[4][4], OVR::Matrix4f* const* out) {
+  Lane4 res[4][4];
+  for (int r = 0; r < 4; ++r) {
+    for (int c = 0; c < 4; ++c) {
+      Lane4 sum = Lane4Mul(a[r][0], b[0][c]);
+      sum = Lane4Add(sum, Lane4Mul(a[r][1], b[1][c]));
+      sum = Lane4Add(sum, Lane4Mul(a[r][2], b[2][c]));
+      sum = Lane4Add(sum, Lane4Mul(a[r][3], b[3][c]));
+      res[r][c] = sum;
+    }
+  }
+  for (int r = 0; r < 4; ++r) {
+    Lane4Transpose(res[r][0], res[r][1], res[r][2], res[r][3]);
+    for (int j = 0; j < 4; ++j) {
+      Lane4Store(out[j]->M[r], res[r][j]);
+    }
+  }
+}
+
+// Rotation and scale for one node, with negated terms kept separate so the
+// lanes see exactly the products the single node path computes
+static void ComposeRotationScale(const TransformSoA& trs, int i, float rs[3][3]) {
+  float cx = cosf(trs.rotX[i]), sx = sinf(trs.rotX[i]);
+  float cy = cosf(trs.rotY[i]), sy = sinf(trs.rotY[i]);
+  float cz = cosf(trs.rotZ[i]), sz = sinf(trs.rotZ[i]);
+
+  // RotationX * RotationY * RotationZ expanded, with each column scaled
+  rs[0][0] = (cy * cz) * trs.sclX[i];
+  rs[0][1] = (-cy * sz) * trs.sclY[i];
+  rs[0][2] = sy * trs.sclZ[i];
+  rs[1][0] = (sx * sy * cz + cx * sz) * trs.sclX[i];
+  rs[1][1] = (cx * cz - sx * sy * sz) * trs.sclY[i];
+  rs[1][2] = (-sx * cy) * trs.sclZ[i];
+  rs[2][0] = (sx * sz - cx * sy * cz) * trs.sclX[i];
+  rs[2][1] = (cx * sy * sz + sx * cz) * trs.sclY[i];
+  rs[2][2] = (cx * cy) * trs.sclZ[i];
+}
+
+static void ComposeOne(const TransformSoA& trs, int i, OVR::Matrix4f* locals) {
+  float rs[3][3];
+  ComposeRotationScale(trs, i, rs);
+
+  OVR::Matrix4f rsMatrix;
+  for (int r = 0; r < 3; ++r) {
+    for (int c = 0; c < 3; ++c) {
+      rsMatrix.M[r][c] = rs[r][c];
+    }
+  }
+
+  OVR::Matrix4f& local = locals[i];
+  TransformKernel_Multiply(trs.base[i], rsMatrix, local);
+  local.M[0][3] = trs.posX[i];
+  local.M[1][3] = trs.posY[i];
+  local.M[2][3] = trs.posZ[i];
+}
+
+void TransformKernel_ComposeLocal(const TransformSoA& trs, const int* indices, int count, OVR::Matrix4f* locals) {
+  int n = 0;
+  for (; n + 4 <= count; n += 4) {
+    // The trig is scalar, the 4x4 products run a node per lane
+    float rs[3][3][4];
+    const OVR::Matrix4f* bases[4];
+    OVR::Matrix4f* outs[4];
+    for (int j = 0; j < 4; ++j) {
+      int i = indices[n + j];
+      float nodeRs[3][3];
+      ComposeRotationScale(trs, i, nodeRs);
+      for (int r = 0; r < 3; ++r) {
+        for (int c = 0; c < 3; ++c) {
+          rs[r][c][j] = nodeRs[r][c];
+        }
+      }
+      bases[j] = &trs.base[i];
+      outs[j] = &locals[i];
+    }
+
+    Lane4 a[4][4];
+    Lane4 b[4][4];
+    LoadLanes(bases, a);
+    Lane4 zero = Lane4Splat(0.0f);
+    for (int r = 0; r < 3; ++r) {
+      for (int c = 0; c < 3; ++c) {
+        b[r][c] = Lane4Load(rs[r][c]);
+      }
+      b[r][3] = zero;
+      b[3][r] = zero;
+    }
+    b[3][3] = Lane4Splat(1.0f);
+    MultiplyLanes(a, b, outs);
+
+    for (int j = 0; j < 4; ++j) {
+      int i = indices[n + j];
+      locals[i].M[0][3] = trs.posX[i];
+      locals[i].M[1][3] = trs.posY[i];
+      locals[i].M[2][3] = trs.posZ[i];
+    }
+  }
+  for (; n < count; ++n) {
+    ComposeOne(trs, indices[n], locals);
+  }
+}
+
+void TransformKernel_ComputeWorld(const int* parents, const OVR::Matrix4f* locals, OVR::Matrix4f* worlds, const int* indices, int count) {
+  int n = 0;
+  while (n < count) {
+    // Four nodes can share a batch when none of them is a root and none of
+    // their parents is in the batch. Parents precede children, so a parent
+    // before the first node is already final.
+    if (n + 4 <= count) {
+      int first = indices[n];
+      bool batch = true;
+      for (int j = 0; j < 4; ++j) {
+        int parent = parents[indices[n + j]];
+        if (parent == -1 || parent >= first) {
+          batch = false;
+          break;
+        }
+      }
+      if (batch) {
+        const OVR::Matrix4f* parentWorlds[4];
+        const OVR::Matrix4f* nodeLocals[4];
+        OVR::Matrix4f* outs[4];
+        for (int j = 0; j < 4; ++j) {
+          int i = indices[n + j];
+          parentWorlds[j] = &worlds[parents[i]];
+          nodeLocals[j] = &locals[i];
+          outs[j] = &worlds[i];
+        }
+        Lane4 a[4][4];
+        Lane4 b[4][4];
+        LoadLanes(parentWorlds, a);
+        LoadLanes(nodeLocals, b);
+        MultiplyLanes(a, b, outs);
+        n += 4;
+        continue;
+      }
+    }
+
+    int i = indices[n];
+    int parent = parents[i];
+    if (parent == -1) {
+      worlds[i] = locals[i];
+    } else {
+      TransformKernel_Multiply(worlds[parent], locals[i], worlds[i]);
+    }
+    ++n;
+  }
+}
+
+#ifdef FLINT_BENCHMARK
+
+static float RandomFloat(float range) {
+  return ((float)rand() / (float)RAND_MAX) * range;
+}
+
+static void BenchmarkNodeCount(int count) {
+  const int ROUNDS = 20;
+
+  // Random hierarchy where every parent precedes its children
+  OVR::Array<int> parents;
+  OVR::Array<int> indices;
+  TransformSoA trs;
+  parents.Resize(count);
+  indices.Resize(count);
+  trs.Resize(count);
+  for (int i = 0; i < count; ++i) {
+    parents[i] = i == 0 ? -1 : rand() % i;
+    indices[i] = i;
+    trs.posX[i] = RandomFloat(10); trs.posY[i] = RandomFloat(10); trs.posZ[i] = RandomFloat(10);
+    trs.rotX[i] = RandomFloat(6); trs.rotY[i] = RandomFloat(6); trs.rotZ[i] = RandomFloat(6);
+    trs.sclX[i] = 1 + RandomFloat(1); trs.sclY[i] = 1 + RandomFloat(1); trs.sclZ[i] = 1 + RandomFloat(1);
+    trs.base[i] = OVR::Matrix4f();
+  }
+
+  // The original per-node path through OVR::Matrix4f
+  OVR::Array<OVR::Matrix4f> nodeWorlds;
+  nodeWorlds.Resize(count);
+  double start = vrapi_GetTimeInSeconds();
+  for (int round = 0; round < ROUNDS; ++round) {
+    for (int i = 0; i < count; ++i) {
+      OVR::Matrix4f mtx = trs.base[i];
+      mtx *= (
+        OVR::Matrix4f::RotationX(trs.rotX[i]) *
+        OVR::Matrix4f::RotationY(trs.rotY[i]) *
+        OVR::Matrix4f::RotationZ(trs.rotZ[i])
+      );
+      mtx *= OVR::Matrix4f::Scaling(trs.sclX[i], trs.sclY[i], trs.sclZ[i]);
+      mtx.SetTranslation(OVR::Vector3f(trs.posX[i], trs.posY[i], trs.posZ[i]));
+      nodeWorlds[i] = parents[i] == -1 ? mtx : nodeWorlds[parents[i]] * mtx;
+    }
+  }
+  double nodeSeconds = (vrapi_GetTimeInSeconds() - start) / ROUNDS;
+
+  // The batched kernel
+  OVR::Array<OVR::Matrix4f> locals;
+  OVR::Array<OVR::Matrix4f> worlds;
+  locals.Resize(count);
+  worlds.Resize(count);
+  start = vrapi_GetTimeInSeconds();
+  for (int round = 0; round < ROUNDS; ++round) {
+    TransformKernel_ComposeLocal(trs, &indices[0], count, &locals[0]);
+    TransformKernel_ComputeWorld(&parents[0], &locals[0], &worlds[0], &indices[0], count);
+  }
+  double kernelSeconds = (vrapi_GetTimeInSeconds() - start) / ROUNDS;
+
+  // Sanity check that both paths agree (up to float reassociation)
+  float maxError = 0;
+  for (int i = 0; i < count; ++i) {
+    for (int r = 0; r < 4; ++r) {
+      for (int c = 0; c < 4; ++c) {
+        maxError = OVR::Alg::Max(maxError, fabsf(worlds[i].M[r][c] - nodeWorlds[i].M[r][c]));
+      }
+    }
+  }
+
+  __android_log_print(ANDROID_LOG_INFO, LOG_COMPONENT,
+    "Transform benchmark: %d nodes, per-node %.3fms, %s kernel %.3fms (%.2fx), max error %g\n",
+    count, nodeSeconds * 1000.0, TransformKernel_Name(), kernelSeconds * 1000.0,
+    nodeSeconds / kernelSeconds, maxError);
+}
+
+void TransformKernel_Benchmark() {
+  srand(1);
+  BenchmarkNodeCount(1000);
+  BenchmarkNodeCount(10000);
+  BenchmarkNodeCount(100000);
+}
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef TRANSFORM_KERNEL_H
+#define TRANSFORM_KERNEL_H
+
+#include "BaseInclude.h"
+
+// Pick the matrix kernel at build time. Define FLINT_SCALAR_TRANSFORMS to force
+// the portable version. All three agree to within denormal flushing, which
+// ARMv7 NEON does and the scalar version doesn't.
+#if defined(FLINT_SCALAR_TRANSFORMS)
+#define TRANSFORM_KERNEL_SCALAR
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define TRANSFORM_KERNEL_NEON
+#elif defined(__SSE__) || defined(__SSE2__)
+#define TRANSFORM_KERNEL_SSE
+#else
+#define TRANSFORM_KERNEL_SCALAR
+#endif
+
+// Local transform inputs for every node in a scene graph, stored
+// structure-of-arrays so the kernels can stream through them
+class TransformSoA {
+public:
+  OVR::Array<float> posX, posY, posZ;
+  OVR::Array<float> rotX, rotY, rotZ;
+  OVR::Array<float> sclX, sclY, sclZ;
+  OVR::Array<OVR::Matrix4f> base;
+
+  void Resize(int count);
+};
+
+const char* TransformKernel_Name();
+
+// out = a * b, for row-major 4x4 matrices (same convention as OVR::Matrix4f)
+void TransformKernel_Multiply(const OVR::Matrix4f& a, const OVR::Matrix4f& b, OVR::Matrix4f& out);
+
+// Builds base * RotationX * RotationY * RotationZ * Scaling, then overwrites the
+// translation with the position, for each listed node. Nodes go four at a time,
+// one per SIMD lane.
+void TransformKernel_ComposeLocal(const TransformSoA& trs, const int* indices, int count, OVR::Matrix4f* locals);
+
+// worlds[i] = worlds[parents[i]] * locals[i] for each listed node. Indices must
+// be ascending and parents must come before their children. Runs of four nodes
+// whose parents are already done go one per SIMD lane.
+void TransformKernel_ComputeWorld(const int* parents, const OVR::Matrix4f* locals, OVR::Matrix4f* worlds, const int* indices, int count);
+
+#ifdef FLINT_BENCHMARK
+void TransformKernel_Benchmark();
+#endif
+
+#endif
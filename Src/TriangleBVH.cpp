@@ -0,0 +1,195 @@
+#include "TriangleBVH.h"
+
+
+static const int BVH_LEAF_TRIANGLES = 4;
+static const int BVH_MAX_DEPTH = 64;
+
+struct BuildTask {
+  int node;
+  int first;
+  int count;
+  int depth;
+};
+
+void TriangleBVH::Build(const OVR::Array<OVR::Vector3f>& positions, const OVR::Array<uint32_t>& indices) {
+  nodes.Clear();
+  triangles.Clear();
+
+  int triangleCount = indices.GetSizeI() / 3;
+  if (triangleCount == 0) {
+    return;
+  }
+
+  // Per triangle bounds and centroids, so the split loop doesn't keep looking
+  // up vertices
+  OVR::Array<OVR::Bounds3f> triBounds;
+  OVR::Array<OVR::Vector3f> centroids;
+  triBounds.Resize(triangleCount);
+  centroids.Resize(triangleCount);
+  triangles.Resize(triangleCount);
+  for (int i = 0; i < triangleCount; ++i) {
+    const OVR::Vector3f& v0 = positions[indices[i * 3]];
+    const OVR::Vector3f& v1 = positions[indices[i * 3 + 1]];
+    const OVR::Vector3f& v2 = positions[indices[i * 3 + 2]];
+    triBounds[i] = OVR::Bounds3f(v0, v0);
+    triBounds[i].AddPoint(v1);
+    triBounds[i].AddPoint(v2);
+    centroids[i] = (v0 + v1 + v2) * (1.0f / 3.0f);
+    triangles[i] = i;
+  }
+
+  nodes.Reserve(triangleCount * 2 / BVH_LEAF_TRIANGLES + 1);
+  nodes.PushBack(Node());
+
+  OVR::Array<BuildTask> stack;
+  BuildTask root = { 0, 0, triangleCount, 0 };
+  stack.PushBack(root);
+  while (stack.GetSizeI() > 0) {
+    BuildTask task = stack.Back();
+    stack.PopBack();
+
+    OVR::Bounds3f bounds = triBounds[triangles[task.first]];
+    OVR::Bounds3f centroidBounds(centroids[triangles[task.first]], centroids[triangles[task.first]]);
+    for (int i = task.first + 1; i < task.first + task.count; ++i) {
+      bounds.AddPoint(triBounds[triangles[i]].GetMins());
+      bounds.AddPoint(triBounds[triangles[i]].GetMaxs());
+      centroidBounds.AddPoint(centroids[triangles[i]]);
+    }
+    nodes[task.node].bounds = bounds;
+
+    // Split at the centroid midpoint of the longest axis
+    OVR::Vector3f extent = centroidBounds.GetMaxs() - centroidBounds.GetMins();
+    int axis = 0;
+    if (extent.y > extent[axis]) axis = 1;
+    if (extent.z > extent[axis]) axis = 2;
+
+    if (task.count <= BVH_LEAF_TRIANGLES || task.depth >= BVH_MAX_DEPTH || extent[axis] <= 0.0f) {
+      nodes[task.node].first = task.first;
+      nodes[task.node].count = task.count;
+      continue;
+    }
+
+    float split = (centroidBounds.GetMins()[axis] + centroidBounds.GetMaxs()[axis]) * 0.5f;
+    int lo = task.first;
+    int hi = task.first + task.count - 1;
+    while (lo <= hi) {
+      if (centroids[triangles[lo]][axis] < split) {
+        ++lo;
+      } else {
+        int tmp = triangles[lo];
+        triangles[lo] = triangles[hi];
+        triangles[hi] = tmp;
+        --hi;
+      }
+    }
+    int leftCount = lo - task.first;
+    if (leftCount == 0 || leftCount == task.count) {
+      leftCount = task.count / 2;
+    }
+
+    int left = nodes.GetSizeI();
+    nodes.PushBack(Node());
+    nodes.PushBack(Node());
+    nodes[task.node].first = left;
+    nodes[task.node].count = 0;
+
+    BuildTask leftTask = { left, task.first, leftCount, task.depth + 1 };
+    BuildTask rightTask = { left + 1, task.first + leftCount, task.count - leftCount, task.depth + 1 };
+    stack.PushBack(rightTask);
+    stack.PushBack(leftTask);
+  }
+}
+
+// Slab test, returning the entry distance
+static bool IntersectRayBounds(const OVR::Vector3f& origin, const OVR::Vector3f& invDir, const OVR::Bounds3f& bounds, float maxT, float& tEntry) {
+  float tMin = 0.0f;
+  float tMax = maxT;
+  for (int axis = 0; axis < 3; ++axis) {
+    float t0 = (bounds.GetMins()[axis] - origin[axis]) * invDir[axis];
+    float t1 = (bounds.GetMaxs()[axis] - origin[axis]) * invDir[axis];
+    if (t0 > t1) {
+      float tmp = t0;
+      t0 = t1;
+      t1 = tmp;
+    }
+    tMin = OVR::Alg::Max(tMin, t0);
+    tMax = OVR::Alg::Min(tMax, t1);
+    if (tMin > tMax) {
+      return false;
+    }
+  }
+  tEntry = tMin;
+  return true;
+}
+
+// Two sided Moller-Trumbore, so one test covers the front and the back face
+static bool IntersectRayTriangle(const OVR::Vector3f& origin, const OVR::Vector3f& dir,
+                                 const OVR::Vector3f& v0, const OVR::Vector3f& v1, const OVR::Vector3f& v2,
+                                 float& t) {
+  OVR::Vector3f edge1 = v1 - v0;
+  OVR::Vector3f edge2 = v2 - v0;
+  OVR::Vector3f pvec = dir.Cross(edge2);
+  float det = edge1.Dot(pvec);
+  if (fabsf(det) < 1e-12f) {
+    return false;
+  }
+  float invDet = 1.0f / det;
+  OVR::Vector3f tvec = origin - v0;
+  float u = tvec.Dot(pvec) * invDet;
+  if (u < 0.0f || u > 1.0f) {
+    return false;
+  }
+  OVR::Vector3f qvec = tvec.Cross(edge1);
+  float v = dir.Dot(qvec) * invDet;
+  if (v < 0.0f || u + v > 1.0f) {
+    return false;
+  }
+  t = edge2.Dot(qvec) * invDet;
+  return t >= 0.0f;
+}
+
+bool TriangleBVH::IntersectRay(const OVR::Vector3f& origin, const OVR::Vector3f& dir,
+                               const OVR::Array<OVR::Vector3f>& positions, const OVR::Array<uint32_t>& indices,
+                               float& tOut) const {
+  if (nodes.GetSizeI() == 0) {
+    return false;
+  }
+
+  OVR::Vector3f invDir(
+    dir.x != 0.0f ? 1.0f / dir.x : FLT_MAX,
+    dir.y != 0.0f ? 1.0f / dir.y : FLT_MAX,
+    dir.z != 0.0f ? 1.0f / dir.z : FLT_MAX);
+
+  float nearest = FLT_MAX;
+  int stack[BVH_MAX_DEPTH * 2 + 2];
+  int stackSize = 0;
+  stack[stackSize++] = 0;
+  while (stackSize > 0) {
+    const Node& node = nodes[stack[--stackSize]];
+    float tEntry;
+    if (!IntersectRayBounds(origin, invDir, node.bounds, nearest, tEntry)) {
+      continue;
+    }
+
+    if (node.count > 0) {
+      for (int i = node.first; i < node.first + node.count; ++i) {
+        int tri = triangles[i] * 3;
+        float t;
+        if (IntersectRayTriangle(origin, dir,
+                                 positions[indices[tri]], positions[indices[tri + 1]], positions[indices[tri + 2]],
+                                 t) && t < nearest) {
+          nearest = t;
+        }
+      }
+    } else {
+      stack[stackSize++] = node.first + 1;
+      stack[stackSize++] = node.first;
+    }
+  }
+
+  if (nearest == FLT_MAX) {
+    return false;
+  }
+  tOut = nearest;
+  return true;
+}
@@ -0,0 +1,28 @@
+#ifndef TRIANGLE_BVH_H
+#define TRIANGLE_BVH_H
+
+#include "BaseInclude.h"
+
+// A bounding volume hierarchy over a mesh's triangles, built in model space so
+// it never has to change when the model moves. Rays get transformed into model
+// space instead.
+class TriangleBVH {
+public:
+  struct Node {
+    OVR::Bounds3f bounds;
+    int first; // First child for inner nodes, first triangle for leaves
+    int count; // Triangle count for leaves, 0 for inner nodes
+  };
+
+  OVR::Array<Node> nodes;
+  OVR::Array<int> triangles; // Triangle numbers, ordered so each leaf is a contiguous range
+
+  void Build(const OVR::Array<OVR::Vector3f>& positions, const OVR::Array<uint32_t>& indices);
+  // Finds the nearest two-sided hit along the ray. The direction doesn't need
+  // to be unit length; t is in multiples of it.
+  bool IntersectRay(const OVR::Vector3f& origin, const OVR::Vector3f& dir,
+                    const OVR::Array<OVR::Vector3f>& positions, const OVR::Array<uint32_t>& indices,
+                    float& tOut) const;
+};
+
+#endif
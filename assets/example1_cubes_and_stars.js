@@ -22,13 +22,13 @@ function vrmain(env) {
     '#version 300 es\n'+
     'in vec3 Position;\n'+
     'in vec4 VertexColor;\n'+
-    'uniform mat4 Modelm;\n'+
+    'in mat4 ModelmInstanced;\n'+ // Lets the cubes be drawn in one instanced call
     'uniform mat4 Viewm;\n'+
     'uniform mat4 Projectionm;\n'+
     'out vec4 fragmentColor;\n'+
     'void main()\n'+
     '{\n'+
-    ' gl_Position = Projectionm * (Viewm * (Modelm * vec4(Position, 1.0)));\n'+
+    ' gl_Position = Projectionm * (Viewm * (ModelmInstanced * vec4(Position, 1.0)));\n'+
     ' fragmentColor = VertexColor;\n'+
     '}'
   ), (